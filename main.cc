@@ -37,8 +37,9 @@ Error run(const ArgList args)
 int main(int argc, char* argv[])
 {
         const auto args = util::argsToList(argc, argv);
+        /// errors stay out of the data when -o - sends it to stdout
         if (const auto e = run(args)) {
-                std::cout << *e << "\n";
+                (*e == util::HELP ? std::cout : std::cerr) << *e << "\n";
                 return 1;
         }
         return 0;
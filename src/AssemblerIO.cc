@@ -15,27 +15,539 @@
  */
 
 #include "src/AssemblerIO.hh"
-#include "src/utils.hh"
 #include "src/Row.hh"
-#include <fstream>
-#include <iostream>
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include "src/Durability.hh"
+#include "src/Crc32.hh"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <limits>
+#include <thread>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// a piece of the output no larger than a buffer
+struct Chunk {
+        size_t part;
+        off_t from; /// in the part's data
+        std::streamsize length;
+        bool spliced; /// page cache straight into the pipe
+};
+
+Error writeAll(const FileDesc& out, const char* p, std::streamsize len)
+{
+        while (len) {
+                const auto w = ::write(out.get(), p, len);
+                if (w == -1 && errno == EINTR)
+                        continue;
+                if (w == -1)
+                        return util::sysError("Write failed", out.path());
+                p += w;
+                len -= w;
+        }
+        return NONE;
+}
+
+/// Moves file pages into the pipe without copying them. Filesystems that
+/// cannot splice fall back to a plain read and write through scratch, which
+/// holds at least len bytes.
+Error spliceAll(const FileDesc& in, off_t off, std::streamsize len,
+    const FileDesc& out, char* scratch)
+{
+        while (len) {
+                const auto s = ::splice(in.get(), &off, out.get(), nullptr,
+                    len, SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (s == -1 && errno == EINTR)
+                        continue;
+                if (s == -1 && errno == EINVAL) {
+                        const auto r = in.readAt(scratch, len, off);
+                        if (!r)
+                                return r.error();
+                        if (*r != len)
+                                return "Stripe shrank: " + in.path();
+                        return writeAll(out, scratch, len);
+                }
+                if (s == -1)
+                        return util::sysError("Splice failed", in.path());
+                if (s == 0)
+                        return "Stripe shrank: " + in.path();
+                len -= s;
+        }
+        return NONE;
+}
+
+} /// namespace
+
+/// files in the order given, each one directly after the last
+Maybe<Parts> AssemblerIO::layout(FilesL files) const
+{
+        Parts parts;
+        off_t to = 0;
+        for (; files; files = files->next_) {
+                std::error_code ec;
+                const auto size = fs::file_size(files->val_, ec);
+                if (ec)
+                        return makeBad<Parts>("Failed to stat: " + files->val_
+                            + " (" + ec.message() + ")\nDiscard output");
+                parts.push_back({ files->val_, 0, to,
+                    static_cast<std::streamsize>(size) });
+                to += size;
+        }
+        return parts;
+}
 
-Maybe<std::streamsize> AssemblerIO::writeStripe(FilesL files,
-    std::ofstream& out, const bool silence)
+bool AssemblerIO::copy(const Part& part, const FileDesc& out,
+    IOBuffer& buffer, const bool silence, const IOPolicy& io)
 {
+        /// parts of a bundle share one descriptor
+        const auto own = part.file ? Maybe<FileDesc>(FileDesc())
+                                   : FileDesc::openRead(part.path);
+        if (!own) {
+                fail(own.error() + "\nDiscard output");
+                return false;
+        }
+        const auto& file = part.file ? *part.file : *own;
+        auto codec = Codec::create(compression_);
+        if (!codec) {
+                fail(codec.error());
+                return false;
+        }
+        std::uint32_t crc = 0;
+        const auto transfer = *codec
+            ? (*codec)->unpack(file, part.stored, out, part.to, io.sparse)
+            : buffer.chunk(file, part.from, out, part.to, part.length, io,
+                part.crc ? &crc : nullptr);
+        if (!transfer) {
+                fail(transfer.error());
+                return false;
+        }
+        if (*transfer != part.length) {
+                fail("Stripe shrank: " + part.path + "\nDiscard output");
+                return false;
+        }
+        if (part.crc && crc != *part.crc) {
+                fail("Checksum mismatch: " + part.path + "\nDiscard output");
+                return false;
+        }
+        if (!silence) {
+                std::lock_guard<std::mutex> lock(amtx_);
+                Row::print(LEFT, part.path, *transfer);
+        }
+        return true;
+}
+
+/// Every part has a fixed output offset, so threads take the next part in
+/// order and write it positionally without waiting on each other. Packed
+/// stripes are expanded by the thread that takes them.
+Maybe<std::streamsize> AssemblerIO::writeStripe(const Parts& parts,
+    const FileDesc& out, const bool silence, const IOPolicy& io,
+    const int threads)
+{
+        std::atomic<size_t> next = 0;
+        const auto work = [&]() {
+                IOBuffer buffer;
+                for (auto i = next++; i < parts.size() && !failure_; i = next++)
+                        if (!copy(parts[i], out, buffer, silence, io))
+                                return;
+        };
+        const auto t = std::min<size_t>(std::max(1, threads), parts.size());
+        std::vector<std::thread> pool;
+        for (size_t i = 1; i < t; i++)
+                pool.emplace_back(work);
+        work();
+        for (auto& th : pool)
+                th.join();
+        if (failure_)
+                return makeBad<std::streamsize>(fmsg_);
         std::streamsize bytes = 0;
-        while (files) {
-                const std::string& path = files->val_;
-                std::ifstream file(path, std::ios::binary);
+        for (const auto& p : parts)
+                bytes += p.length;
+        return bytes;
+}
+
+Error AssemblerIO::reserve(const std::uintmax_t total, const std::string& out)
+    const
+{
+        const auto dir = fs::path(out).parent_path().string();
+        return util::checkSpace(dir.empty() ? "." : dir, total);
+}
+
+/// checks space, preallocates, runs the writer and makes the result durable
+Error AssemblerIO::output(const std::uintmax_t total, const std::string& out,
+    const bool silence, const IOPolicy& io, const Writer& write)
+{
+        if (const auto e = reserve(total, out))
+                return *e;
+        auto output = FileDesc::openWrite(out);
+        if (!output)
+                return output.error();
+        if (const auto e = output->allocate(total, io.sparse))
+                return *e;
+        const auto bytes = write(*output);
+        if (!bytes)
+                return bytes.error();
+        if (!silence)
+                Row::print(RIGHT, out, *bytes);
+        Durability dur(io.sync);
+        if (const auto e = dur.settle(output.extract()))
+                return *e;
+        if (const auto e = dur.finish({ fs::path(out).parent_path() }))
+                return *e;
+        if (!silence && io.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
+}
+
+/// -o -: readers run ahead of the writer by a window of chunks, filling a
+/// pool buffer each, while the writer sends chunks to stdout in order. The
+/// window shrinks to what --max-memory allows. When stdout
+/// is a pipe plain stripes are spliced and the readers only pull them into
+/// the page cache. Checksums are taken by the writer as bytes go out.
+Error AssemblerIO::stream(Parts parts, const int threads)
+{
+        std::sort(parts.begin(), parts.end(), [](const auto& a,
+            const auto& b) {
+                return a.to < b.to;
+        });
+        off_t end = 0;
+        for (const auto& p : parts) {
+                if (p.to != end)
+                        return "Stripes leave a gap at " + std::to_string(end);
+                end += p.length;
+        }
+        const FileDesc out(::dup(STDOUT_FILENO), "stdout");
+        if (!out)
+                return util::sysError("Failed to open", "stdout");
+        struct stat st;
+        if (::fstat(out.get(), &st) == -1)
+                return util::sysError("stat", "stdout");
+        const bool pipe = S_ISFIFO(st.st_mode);
+        auto& buffers = BufferPool::instance();
+        const std::streamsize most = buffers.size();
+        std::vector<Chunk> chunks;
+        for (size_t i = 0; i < parts.size(); i++) {
+                const auto& p = parts[i];
+                const bool spliced = pipe && !p.stored && !p.crc;
+                for (std::streamsize at = 0; at < p.length; at += most)
+                        chunks.push_back({ i, at, std::min(most,
+                            p.length - at), spliced });
+        }
+        const auto cap = buffers.capacity();
+        const size_t window = std::min<size_t>(2 * std::max(1, threads),
+            cap ? cap : std::numeric_limits<size_t>::max());
+        std::vector<BufferPool::Lease> slots;
+        for (size_t w = 0; w < window; w++) {
+                slots.push_back(buffers.checkout());
+                if (!slots.back())
+                        return "Failed to map i/o buffer";
+        }
+        std::vector<bool> ready(chunks.size(), false);
+        size_t written = 0;
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::atomic<size_t> next = 0;
+        /// Stripes are opened by the first reader to reach them and closed
+        /// once the writer is past them, so only the stripes within the
+        /// window hold a descriptor. Parts of a bundle keep its shared one.
+        std::vector<std::shared_ptr<const FileDesc>> files(parts.size());
+        std::mutex omtx;
+        BlockIndexes indexes;
+        const auto open = [&](const size_t i) {
+                std::lock_guard<std::mutex> lock(omtx);
+                if (files[i])
+                        return Maybe<std::shared_ptr<const FileDesc>>(
+                            files[i]);
+                if (parts[i].file)
+                        return Maybe<std::shared_ptr<const FileDesc>>(
+                            files[i] = parts[i].file);
+                auto file = FileDesc::openRead(parts[i].path);
                 if (!file)
-                        return makeBad<std::streamsize>(
-                            "Failed to open: " + path + "\nDiscard output");
-                const auto size = util::fileSize(file);
-                const auto transfer = chunk(file, out, size);
+                        return makeBad<std::shared_ptr<const FileDesc>>(
+                            file.error());
+                files[i] = std::make_shared<const FileDesc>(file.extract());
+                return Maybe<std::shared_ptr<const FileDesc>>(files[i]);
+        };
+        const auto read = [&]() {
+                auto codec = Codec::create(compression_);
+                if (!codec) {
+                        fail(codec.error());
+                        return;
+                }
+                for (size_t i; (i = next++) < chunks.size() && !failure_; ) {
+                        {
+                                std::unique_lock<std::mutex> lock(mtx);
+                                cv.wait(lock, [&] {
+                                        return i < written + window
+                                            || failure_;
+                                });
+                        }
+                        if (failure_)
+                                break;
+                        const auto& c = chunks[i];
+                        const auto& p = parts[c.part];
+                        auto& slot = slots[i % window];
+                        const auto file = open(c.part);
+                        Error e = NONE;
+                        if (!file) {
+                                e = file.error();
+                        } else if (c.spliced) {
+                                ::readahead((*file)->get(), p.from + c.from,
+                                    c.length);
+                        } else if (p.stored) {
+                                const auto index = indexes.get(**file,
+                                    p.stored);
+                                e = !index ? index.error()
+                                    : (*codec)->extract(**file, **index,
+                                        c.from, c.length, slot.data());
+                        } else {
+                                const auto r = (*file)->readAt(slot.data(),
+                                    c.length, p.from + c.from);
+                                if (!r)
+                                        e = r.error();
+                                else if (*r != c.length)
+                                        e = "Stripe shrank: " + p.path;
+                        }
+                        std::lock_guard<std::mutex> lock(mtx);
+                        if (e)
+                                fail(*e);
+                        ready[i] = true;
+                        cv.notify_all();
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                cv.notify_all();
+        };
+        std::vector<std::thread> pool;
+        for (int t = 0; t < std::max(1, threads); t++)
+                pool.emplace_back(read);
+        std::uint32_t crc = 0;
+        for (size_t i = 0; i < chunks.size(); i++) {
+                {
+                        std::unique_lock<std::mutex> lock(mtx);
+                        cv.wait(lock, [&] { return ready[i] || failure_; });
+                }
+                if (failure_)
+                        break;
+                const auto& c = chunks[i];
+                const auto& p = parts[c.part];
+                const auto& slot = slots[i % window];
+                const auto file = files[c.part];
+                auto e = c.spliced
+                    ? spliceAll(*file, p.from + c.from, c.length, out,
+                        slot.data())
+                    : writeAll(out, slot.data(), c.length);
+                if (p.crc && !c.spliced)
+                        crc = crc32::update(crc, slot.data(), c.length);
+                if (!e && p.crc && c.from + c.length == p.length) {
+                        if (crc != *p.crc)
+                                e = "Checksum mismatch: " + p.path;
+                        crc = 0;
+                }
+                if (c.from + c.length == p.length) {
+                        std::lock_guard<std::mutex> lock(omtx);
+                        files[c.part].reset();
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                if (e)
+                        fail(*e);
+                written++;
+                cv.notify_all();
+        }
+        for (auto& th : pool)
+                th.join();
+        if (failure_)
+                return fmsg_;
+        return NONE;
+}
+
+/// --in-place: the first stripe becomes the output and the others are
+/// appended in order, each deleted once the output holding it is synced.
+/// Beyond the set itself only one stripe's worth of space is needed.
+Error AssemblerIO::inPlace(Parts parts, const std::string& out,
+    const bool silence, const IOPolicy& io)
+{
+        std::sort(parts.begin(), parts.end(), [](const auto& a,
+            const auto& b) {
+                return a.to < b.to;
+        });
+        off_t end = 0;
+        std::streamsize largest = 0;
+        std::unordered_set<std::string> names;
+        for (const auto& p : parts) {
+                if (p.to != end || p.from || p.stored || p.crc || p.file)
+                        return "In place needs plain stripes laid end to end";
+                if (!names.insert(fs::weakly_canonical(p.path)).second)
+                        return "In place needs every stripe once: " + p.path;
+                std::error_code ec;
+                if (fs::file_size(p.path, ec) != static_cast<std::uintmax_t>(
+                    p.length) || ec)
+                        return "Stripe size mismatch: " + p.path;
+                end += p.length;
+                largest = std::max(largest, p.length);
+        }
+        const auto dir = fs::path(out).parent_path().string();
+        struct stat first, target;
+        if (::stat(parts.front().path.c_str(), &first) == -1)
+                return util::sysError("stat", parts.front().path);
+        if (::stat(dir.empty() ? "." : dir.c_str(), &target) == -1)
+                return util::sysError("stat", dir);
+        if (first.st_dev != target.st_dev)
+                return "In place needs the stripes on the output's filesystem";
+        if (const auto e = util::checkSpace(dir.empty() ? "." : dir, largest))
+                return *e;
+        if (std::rename(parts.front().path.c_str(), out.c_str()) == -1)
+                return util::sysError("Failed to rename", parts.front().path);
+        if (!silence)
+                Row::print(SAME, parts.front().path, parts.front().length);
+        auto output = FileDesc::openUpdate(out);
+        if (!output)
+                return output.error();
+        IOBuffer buffer;
+        for (size_t i = 1; i < parts.size(); i++) {
+                const auto& p = parts[i];
+                const auto in = FileDesc::openRead(p.path);
+                if (!in)
+                        return in.error();
+                const auto fast = output->copyFrom(*in, 0, p.to, p.length);
+                if (!fast)
+                        return fast.error();
+                const auto rest = p.length - *fast;
+                const auto slow = rest ? buffer.chunk(*in, *fast, *output,
+                    p.to + *fast, rest, io) : Maybe<std::streamsize>(0);
+                if (!slow)
+                        return slow.error();
+                if (*slow != rest)
+                        return "Stripe shrank: " + p.path;
+                if (const auto e = output->sync())
+                        return *e;
+                if (::unlink(p.path.c_str()) == -1)
+                        return util::sysError("Failed to remove", p.path);
                 if (!silence)
-                        Row::print(LEFT, path, transfer);
-                bytes += transfer;
-                files = files->next_;
+                        Row::print(LEFT, p.path, p.length);
         }
-        return bytes;
+        if (!silence)
+                Row::print(RIGHT, out, end);
+        Durability dur(io.sync);
+        if (const auto e = dur.settle(output.extract()))
+                return *e;
+        std::vector<std::string> dirs = { fs::path(out).parent_path() };
+        for (const auto& p : parts)
+                dirs.push_back(fs::path(p.path).parent_path());
+        if (const auto e = dur.finish(dirs))
+                return *e;
+        if (!silence && io.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
+}
+
+/// --shard k/N: participant k of N writes stripes i % N == k of the shared
+/// output. Each sees the same set and so the same offsets, nothing is
+/// exchanged. The output is opened without truncating and only ever grown
+/// to the total, in whichever order participants arrive, participant 0
+/// also preallocates it and checks the space the output does not hold yet.
+Error AssemblerIO::share(Parts parts, const std::string& out,
+    const size_t shard, const size_t shards, const bool silence,
+    const IOPolicy& io, const int threads)
+{
+        std::sort(parts.begin(), parts.end(), [](const auto& a,
+            const auto& b) {
+                return a.to < b.to;
+        });
+        std::uintmax_t total = 0;
+        for (const auto& p : parts)
+                total = std::max<std::uintmax_t>(total, p.to + p.length);
+        auto output = FileDesc::openUpdate(out);
+        if (!output)
+                return output.error();
+        const auto size = output->size();
+        if (!size)
+                return size.error();
+        if (static_cast<std::uintmax_t>(*size) > total)
+                return "Output is larger than the set: " + out;
+        if (shard == 0) {
+                /// others may have arrived first and written their stripes
+                const auto held = output->allocated();
+                if (!held)
+                        return held.error();
+                const auto have = static_cast<std::uintmax_t>(*held);
+                if (const auto e = reserve(have < total ? total - have : 0,
+                    out))
+                        return *e;
+                if (const auto e = output->allocate(total))
+                        return *e;
+        }
+        if (const auto e = output->extend(total))
+                return *e;
+        Parts mine;
+        for (size_t i = shard; i < parts.size(); i += shards)
+                mine.push_back(std::move(parts[i]));
+        const auto bytes = mine.empty() ? Maybe<std::streamsize>(0)
+            : writeStripe(mine, *output, silence, io, threads);
+        if (!bytes)
+                return bytes.error();
+        if (!silence)
+                Row::print(RIGHT, out, *bytes);
+        Durability dur(io.sync);
+        if (const auto e = dur.settle(output.extract()))
+                return *e;
+        if (const auto e = dur.finish({ fs::path(out).parent_path() }))
+                return *e;
+        if (!silence && io.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
+}
+
+Error AssemblerIO::assemble(const Parts& parts, const std::string& out,
+    const bool silence, const IOPolicy& io, const int threads)
+{
+        if (out == STDOUT_PATH)
+                return stream(parts, threads);
+        std::uintmax_t total = 0;
+        for (const auto& p : parts)
+                total = std::max<std::uintmax_t>(total, p.to + p.length);
+        return output(total, out, silence, io, [&](const FileDesc& fd) {
+                return writeStripe(parts, fd, silence, io, threads);
+        });
+}
+
+Error AssemblerIO::assemble(const Interleave& layout, const FilesL files,
+    const std::string& out, const bool silence, const IOPolicy& io,
+    const int threads)
+{
+        if (out == STDOUT_PATH)
+                return "Interleaved sets are not streamed, use -E";
+        std::vector<FileDesc> inputs;
+        for (auto f = files; f; f = f->next_) {
+                auto in = FileDesc::openRead(f->val_);
+                if (!in)
+                        return in.error() + "\nDiscard output";
+                inputs.push_back(in.extract());
+        }
+        if (inputs.size() != layout.files())
+                return "Interleaved set needs " + std::to_string(layout.files())
+                    + " files";
+        for (size_t k = 0; k < inputs.size(); k++) {
+                const auto size = inputs[k].size();
+                if (!size)
+                        return size.error();
+                if (*size != layout.fileSize(k))
+                        return "Stripe size mismatch: " + inputs[k].path();
+        }
+        const auto join = [&](const FileDesc& fd) {
+                if (const auto e = layout.join(inputs, fd, threads))
+                        return makeBad<std::streamsize>(*e);
+                if (!silence)
+                        for (const auto& in : inputs)
+                                Row::print(LEFT, in.path(), *in.size());
+                return Maybe<std::streamsize>(layout.total());
+        };
+        return output(layout.total(), out, silence, io, join);
 }
@@ -19,12 +19,58 @@
 
 #include "src/Maybe.hh"
 #include "src/IOBuffer.hh"
+#include "src/Failure.hh"
 #include "src/types.hh"
+#include "src/Interleave.hh"
+#include "src/Codec.hh"
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
-class AssemblerIO : protected IOBuffer {
+/// a stripe's bytes and where they land in the output
+struct Part {
+        std::string path;
+        off_t from = 0; /// in the stripe file
+        off_t to = 0;   /// in the output
+        std::streamsize length = 0; /// in the output
+        std::streamsize stored = 0; /// packed size when compressed
+        std::optional<std::uint32_t> crc = std::nullopt; /// checked if set
+        std::shared_ptr<const FileDesc> file = nullptr; /// open, shared
+};
+
+using Parts = std::vector<Part>;
+
+using Writer = std::function<Maybe<std::streamsize>(const FileDesc&)>;
+
+class AssemblerIO : protected Failure {
+private:
+        std::mutex amtx_; /// std::cout
 protected:
-        Maybe<std::streamsize> writeStripe(FilesL files, std::ofstream& out,
-            const bool silence);
+        Compression compression_; /// parts are packed stripes
+        bool copy(const Part& part, const FileDesc& out, IOBuffer& buffer,
+            const bool silence, const IOPolicy& io);
+        Maybe<Parts> layout(FilesL files) const;
+        Maybe<std::streamsize> writeStripe(const Parts& parts,
+            const FileDesc& out, const bool silence, const IOPolicy& io,
+            const int threads);
+        Error reserve(const std::uintmax_t total, const std::string& out)
+            const;
+        Error output(const std::uintmax_t total, const std::string& out,
+            const bool silence, const IOPolicy& io, const Writer& write);
+        Error stream(Parts parts, const int threads);
+        Error inPlace(Parts parts, const std::string& out, const bool silence,
+            const IOPolicy& io);
+        Error share(Parts parts, const std::string& out, const size_t shard,
+            const size_t shards, const bool silence, const IOPolicy& io,
+            const int threads);
+        Error assemble(const Parts& parts, const std::string& out,
+            const bool silence, const IOPolicy& io, const int threads);
+        Error assemble(const Interleave& layout, const FilesL files,
+            const std::string& out, const bool silence, const IOPolicy& io,
+            const int threads);
 public:
         AssemblerIO() = default;
         virtual ~AssemblerIO() = default;
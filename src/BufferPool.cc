@@ -0,0 +1,164 @@
+/**
+ * File: BufferPool.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/BufferPool.hh"
+#include <algorithm>
+#include <cstdint>
+#include <sys/mman.h>
+
+BufferPool::Lease::Lease(BufferPool* pool, char* data)
+    : pool_(pool)
+    , data_(data)
+{ }
+
+BufferPool::Lease::~Lease()
+{
+        if (data_)
+                pool_->checkin(data_);
+}
+
+BufferPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_)
+    , data_(other.data_)
+{
+        other.data_ = nullptr;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept
+{
+        if (this != &other) {
+                if (data_)
+                        pool_->checkin(data_);
+                pool_ = other.pool_;
+                data_ = other.data_;
+                other.data_ = nullptr;
+        }
+        return *this;
+}
+
+BufferPool::Lease::operator bool() const
+{
+        return data_ != nullptr;
+}
+
+char* BufferPool::Lease::data() const
+{
+        return data_;
+}
+
+std::streamsize BufferPool::Lease::size() const
+{
+        return pool_->size();
+}
+
+BufferPool::~BufferPool()
+{
+        for (const auto p : free_)
+                ::munmap(p, mapped_);
+}
+
+BufferPool& BufferPool::instance()
+{
+        static BufferPool pool;
+        return pool;
+}
+
+void BufferPool::configure(const IOPolicy& io)
+{
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto p : free_)
+                ::munmap(p, mapped_);
+        free_.clear();
+        size_ = io.bufferSize;
+        huge_ = io.hugePages;
+        mapped_ = mapLength();
+        /// counted by what is mapped, a huge page buffer rounds up to 2 MiB
+        limit_ = io.maxMemory ? std::max<size_t>(1, io.maxMemory / mapped_)
+                              : 0;
+}
+
+size_t BufferPool::mapLength() const
+{
+        const size_t unit = huge_ ? ALIGN : 4'096;
+        return (size_ + unit - 1) / unit * unit;
+}
+
+/// Explicit huge pages first, otherwise over map and trim to the 2 MiB
+/// boundary so transparent huge pages can back the buffer.
+char* BufferPool::allocate() const
+{
+        constexpr auto prot = PROT_READ | PROT_WRITE;
+        constexpr auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        if (huge_) {
+                void* p = ::mmap(nullptr, mapped_, prot, flags | MAP_HUGETLB,
+                    -1, 0);
+                if (p != MAP_FAILED)
+                        return static_cast<char*>(p);
+        }
+        void* raw = ::mmap(nullptr, mapped_ + ALIGN, prot, flags, -1, 0);
+        if (raw == MAP_FAILED)
+                return nullptr;
+        const auto base = reinterpret_cast<std::uintptr_t>(raw);
+        const auto aligned = (base + ALIGN - 1) / ALIGN * ALIGN;
+        if (aligned > base)
+                ::munmap(raw, aligned - base);
+        const auto tail = ALIGN - (aligned - base);
+        if (tail)
+                ::munmap(reinterpret_cast<char*>(aligned + mapped_), tail);
+        const auto p = reinterpret_cast<char*>(aligned);
+        if (huge_)
+                ::madvise(p, mapped_, MADV_HUGEPAGE);
+        return p;
+}
+
+BufferPool::Lease BufferPool::checkout()
+{
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] {
+                return !free_.empty() || !limit_ || out_ < limit_;
+        });
+        char* data = nullptr;
+        if (!free_.empty()) {
+                data = free_.back();
+                free_.pop_back();
+        } else {
+                data = allocate();
+                if (!data)
+                        return Lease();
+        }
+        out_++;
+        return Lease(this, data);
+}
+
+void BufferPool::checkin(char* data)
+{
+        {
+                std::lock_guard<std::mutex> lock(mtx_);
+                free_.push_back(data);
+                out_--;
+        }
+        cv_.notify_one();
+}
+
+size_t BufferPool::size() const
+{
+        return size_;
+}
+
+size_t BufferPool::capacity() const
+{
+        return limit_;
+}
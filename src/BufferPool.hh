@@ -0,0 +1,70 @@
+/**
+ * File: BufferPool.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef BUFFER_POOL_HH
+#define BUFFER_POOL_HH
+
+#include "src/IOPolicy.hh"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/// Process wide pool of 2 MiB aligned, mmap backed i/o buffers. Buffers are
+/// never zero filled and are reused between checkouts. Checkout blocks once
+/// the memory budget is spent until another buffer is returned.
+class BufferPool {
+private:
+        static constexpr size_t ALIGN = 1'024 * 1'024 * 2;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::vector<char*> free_;
+        size_t size_ = 1'024 * 64;
+        size_t mapped_ = 0;
+        size_t limit_ = 0;
+        size_t out_ = 0;
+        bool huge_ = false;
+        BufferPool() = default;
+        size_t mapLength() const;
+        char* allocate() const;
+        void checkin(char* data);
+public:
+        class Lease {
+        private:
+                BufferPool* pool_ = nullptr;
+                char* data_ = nullptr;
+        public:
+                Lease() = default;
+                Lease(BufferPool* pool, char* data);
+                ~Lease();
+                Lease(const Lease&) = delete;
+                Lease(Lease&& other) noexcept;
+                Lease& operator=(Lease&& other) noexcept;
+                explicit operator bool() const;
+                char* data() const;
+                std::streamsize size() const;
+        };
+        ~BufferPool();
+        BufferPool(const BufferPool&) = delete;
+        static BufferPool& instance();
+        void configure(const IOPolicy& io);
+        Lease checkout();
+        size_t size() const;
+        /// buffers --max-memory allows, 0 without a limit
+        size_t capacity() const;
+};
+
+#endif /// BUFFER_POOL_HH
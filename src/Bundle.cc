@@ -0,0 +1,101 @@
+/**
+ * File: Bundle.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Bundle.hh"
+#include "src/Crc32.hh"
+#include "src/utils.hh"
+#include <cstring>
+
+namespace {
+
+constexpr char MAGIC[8] = { 'Z', 'E', 'B', 'R', 'A', 'B', 'N', '1' };
+
+} /// namespace
+
+std::string Bundle::fileName(const std::string& name)
+{
+        return (name.empty() ? "zebra" : name) + ".bundle";
+}
+
+std::streamsize Bundle::indexSize() const
+{
+        return entries.size() * ENTRY + TRAILER;
+}
+
+Error Bundle::write(const FileDesc& file, const off_t at) const
+{
+        std::vector<char> raw(indexSize(), 0);
+        char* p = raw.data();
+        for (const auto& e : entries) {
+                util::putLE(p, e.index, 8);
+                util::putLE(p + 8, e.offset, 8);
+                util::putLE(p + 16, e.at, 8);
+                util::putLE(p + 24, e.length, 8);
+                util::putLE(p + 32, e.crc, 4);
+                p += ENTRY;
+        }
+        std::memcpy(p, MAGIC, sizeof(MAGIC));
+        std::memcpy(p + 8, set.data(), set.size());
+        util::putLE(p + 24, entries.size(), 8);
+        util::putLE(p + 32, at, 8);
+        util::putLE(p + 40, count, 8);
+        util::putLE(p + 48, size, 8);
+        util::putLE(p + 56, crc32::update(0, raw.data(), raw.size() - 8), 4);
+        return file.writeAt(raw.data(), raw.size(), at);
+}
+
+/// the trailer is read first, it says where the index starts
+Maybe<Bundle> Bundle::read(const FileDesc& file)
+{
+        const auto fsize = file.size();
+        if (!fsize)
+                return makeBad<Bundle>(fsize.error());
+        const auto bad = "Not a bundle: " + file.path();
+        if (*fsize < static_cast<std::streamsize>(TRAILER))
+                return makeBad<Bundle>(bad);
+        char t[TRAILER];
+        if (const auto r = file.readAt(t, TRAILER, *fsize - TRAILER);
+            !r || *r != static_cast<std::streamsize>(TRAILER))
+                return makeBad<Bundle>(r ? bad : r.error());
+        if (std::memcmp(t, MAGIC, sizeof(MAGIC)))
+                return makeBad<Bundle>(bad);
+        Bundle b;
+        std::memcpy(b.set.data(), t + 8, b.set.size());
+        const auto n = util::getLE(t + 24, 8);
+        const auto at = util::getLE(t + 32, 8);
+        b.count = util::getLE(t + 40, 8);
+        b.size = util::getLE(t + 48, 8);
+        if (at + n * ENTRY + TRAILER != static_cast<std::uint64_t>(*fsize))
+                return makeBad<Bundle>("Corrupt bundle index: " + file.path());
+        std::vector<char> raw(n * ENTRY + TRAILER);
+        if (const auto r = file.readAt(raw.data(), raw.size(), at);
+            !r || *r != static_cast<std::streamsize>(raw.size()))
+                return makeBad<Bundle>(r ? bad : r.error());
+        if (util::getLE(raw.data() + raw.size() - 8, 4)
+            != crc32::update(0, raw.data(), raw.size() - 8))
+                return makeBad<Bundle>("Corrupt bundle index: " + file.path());
+        b.entries.reserve(n);
+        for (const char* p = raw.data(); b.entries.size() < n; p += ENTRY) {
+                b.entries.push_back({ util::getLE(p, 8), util::getLE(p + 8, 8),
+                    util::getLE(p + 16, 8), util::getLE(p + 24, 8),
+                    static_cast<std::uint32_t>(util::getLE(p + 32, 4)) });
+                const auto& e = b.entries.back();
+                if (e.at + e.length > at)
+                        return makeBad<Bundle>("Corrupt bundle index: "
+                            + file.path());
+        }
+        return b;
+}
@@ -0,0 +1,58 @@
+/**
+ * File: Bundle.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef BUNDLE_HH
+#define BUNDLE_HH
+
+#include "src/Maybe.hh"
+#include "src/FileDesc.hh"
+#include "src/StripeHeader.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// one stripe inside a bundle
+struct BundleEntry {
+        std::uint64_t index = 0;
+        std::uint64_t offset = 0; /// in the source
+        std::uint64_t at = 0;     /// in the bundle
+        std::uint64_t length = 0;
+        std::uint32_t crc = 0;
+};
+
+/// Container for many stripes of a set, one per output directory. The data
+/// regions come first, then an index of 40 byte entries and a 64 byte
+/// trailer, little endian:
+///
+/// entry   : index, offset, at, length (8 bytes each), CRC-32, 4 zero bytes
+/// trailer : magic "ZEBRABN1", set id (16), entries, index position, stripes
+///           in the set, source size (8 bytes each), CRC-32 of the index and
+///           trailer before it, 4 zero bytes
+struct Bundle {
+        static constexpr size_t ENTRY = 40;
+        static constexpr size_t TRAILER = 64;
+        StripeHeader::SetId set{};
+        std::uint64_t count = 0; /// stripes in the whole set
+        std::uint64_t size = 0;
+        std::vector<BundleEntry> entries;
+        static std::string fileName(const std::string& name);
+        std::streamsize indexSize() const;
+        /// index and trailer at the given position
+        Error write(const FileDesc& file, const off_t at) const;
+        static Maybe<Bundle> read(const FileDesc& file);
+};
+
+#endif /// BUNDLE_HH
@@ -0,0 +1,418 @@
+/**
+ * File: Codec.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Codec.hh"
+#include "src/BufferPool.hh"
+#include "src/Sha256.hh"
+#include "src/scan.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#ifdef ZEBRA_ZSTD
+#include <zstd.h>
+#endif
+#ifdef ZEBRA_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef ZEBRA_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+const std::vector<std::pair<std::string, CodecKind>> NAMES = {
+    { "zstd", CodecKind::ZSTD },
+    { "lz4", CodecKind::LZ4 },
+    { "zlib", CodecKind::ZLIB },
+};
+
+/// highest level each library takes, lz4 levels select lz4hc
+const std::unordered_map<CodecKind, int> MAX_LEVEL = {
+    { CodecKind::ZSTD, 22 },
+    { CodecKind::LZ4, 12 },
+    { CodecKind::ZLIB, 9 },
+};
+
+void putU32(char* p, const std::uint32_t v)
+{
+        for (int i = 0; i < 4; i++)
+                p[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+}
+
+std::uint32_t getU32(const char* p)
+{
+        std::uint32_t v = 0;
+        for (int i = 0; i < 4; i++)
+                v |= static_cast<std::uint32_t>(static_cast<unsigned char>(
+                    p[i])) << (8 * i);
+        return v;
+}
+
+#ifdef ZEBRA_ZSTD
+class Zstd final : public Codec {
+private:
+        const int level_;
+        ZSTD_CCtx* cctx_ = ZSTD_createCCtx();
+        ZSTD_DCtx* dctx_ = ZSTD_createDCtx();
+protected:
+        size_t bound(const size_t n) const override
+        {
+                return ZSTD_compressBound(n);
+        }
+        Maybe<size_t> compress(const char* src, const size_t n, char* dst,
+            const size_t cap) override
+        {
+                const auto r = ZSTD_compressCCtx(cctx_, dst, cap, src, n,
+                    level_);
+                if (ZSTD_isError(r))
+                        return makeBad<size_t>(std::string("zstd: ")
+                            + ZSTD_getErrorName(r));
+                return r;
+        }
+        Error decompress(const char* src, const size_t n, char* dst,
+            const size_t raw) override
+        {
+                const auto r = ZSTD_decompressDCtx(dctx_, dst, raw, src, n);
+                if (ZSTD_isError(r) || r != raw)
+                        return "Corrupt zstd block";
+                return NONE;
+        }
+public:
+        explicit Zstd(const int level)
+            : level_(level ? level : 3)
+        { }
+        ~Zstd()
+        {
+                ZSTD_freeCCtx(cctx_);
+                ZSTD_freeDCtx(dctx_);
+        }
+};
+#endif
+
+#ifdef ZEBRA_LZ4
+class Lz4 final : public Codec {
+private:
+        const int level_; /// 0 is the fast compressor, otherwise lz4hc
+protected:
+        size_t bound(const size_t n) const override
+        {
+                return LZ4_compressBound(static_cast<int>(n));
+        }
+        Maybe<size_t> compress(const char* src, const size_t n, char* dst,
+            const size_t cap) override
+        {
+                const auto r = level_
+                    ? LZ4_compress_HC(src, dst, n, cap, level_)
+                    : LZ4_compress_default(src, dst, n, cap);
+                if (r <= 0)
+                        return makeBad<size_t>("lz4 compression failed");
+                return static_cast<size_t>(r);
+        }
+        Error decompress(const char* src, const size_t n, char* dst,
+            const size_t raw) override
+        {
+                const auto r = LZ4_decompress_safe(src, dst, n, raw);
+                if (r < 0 || static_cast<size_t>(r) != raw)
+                        return "Corrupt lz4 block";
+                return NONE;
+        }
+public:
+        explicit Lz4(const int level)
+            : level_(level)
+        { }
+};
+#endif
+
+#ifdef ZEBRA_ZLIB
+class Zlib final : public Codec {
+private:
+        const int level_;
+protected:
+        size_t bound(const size_t n) const override
+        {
+                return compressBound(n);
+        }
+        Maybe<size_t> compress(const char* src, const size_t n, char* dst,
+            const size_t cap) override
+        {
+                uLongf len = cap;
+                if (compress2(reinterpret_cast<Bytef*>(dst), &len,
+                    reinterpret_cast<const Bytef*>(src), n, level_) != Z_OK)
+                        return makeBad<size_t>("zlib compression failed");
+                return static_cast<size_t>(len);
+        }
+        Error decompress(const char* src, const size_t n, char* dst,
+            const size_t raw) override
+        {
+                uLongf len = raw;
+                if (uncompress(reinterpret_cast<Bytef*>(dst), &len,
+                    reinterpret_cast<const Bytef*>(src), n) != Z_OK
+                    || len != raw)
+                        return "Corrupt zlib block";
+                return NONE;
+        }
+public:
+        explicit Zlib(const int level)
+            : level_(level ? level : Z_DEFAULT_COMPRESSION)
+        { }
+};
+#endif
+
+} /// namespace
+
+Maybe<Compression> Compression::parse(const std::string& spec)
+{
+        const auto colon = spec.find(':');
+        const auto name = spec.substr(0, colon);
+        Compression c;
+        const auto it = std::find_if(NAMES.begin(), NAMES.end(),
+            [&](const auto& n) {
+                return n.first == name;
+        });
+        if (it == NAMES.end())
+                return makeBad<Compression>("Bad compression " + spec);
+        c.kind = it->second;
+        if (colon == std::string::npos)
+                return c;
+        const auto level = spec.substr(colon + 1);
+        if (level.empty() || level.size() > 2
+            || !std::all_of(level.begin(), level.end(), util::isDigit))
+                return makeBad<Compression>("Bad compression level " + level);
+        c.level = std::stoi(level);
+        if (const auto most = MAX_LEVEL.at(c.kind); c.level > most)
+                return makeBad<Compression>("Bad compression level " + level
+                    + ", " + name + " goes up to " + std::to_string(most));
+        return c;
+}
+
+std::string Compression::str() const
+{
+        for (const auto& [name, kind] : NAMES)
+                if (kind == this->kind)
+                        return level ? name + ":" + std::to_string(level)
+                                     : name;
+        return "";
+}
+
+Compression::operator bool() const
+{
+        return kind != CodecKind::NONE;
+}
+
+Maybe<std::unique_ptr<Codec>> Codec::create(const Compression& c)
+{
+        using Ptr = std::unique_ptr<Codec>;
+        switch (c.kind) {
+#ifdef ZEBRA_ZSTD
+        case CodecKind::ZSTD:
+                return Ptr(std::make_unique<Zstd>(c.level));
+#endif
+#ifdef ZEBRA_LZ4
+        case CodecKind::LZ4:
+                return Ptr(std::make_unique<Lz4>(c.level));
+#endif
+#ifdef ZEBRA_ZLIB
+        case CodecKind::ZLIB:
+                return Ptr(std::make_unique<Zlib>(c.level));
+#endif
+        case CodecKind::NONE:
+                return Ptr();
+        default:
+                return makeBad<Ptr>("Built without " + c.str() + " support");
+        }
+}
+
+/// compresses [off, off + len) of in block by block, returns bytes stored,
+/// sha takes the raw bytes as they go by
+Maybe<std::streamsize> Codec::pack(const FileDesc& in, off_t off,
+    std::streamsize len, const FileDesc& out, off_t outOff, Sha256* sha)
+{
+        auto lease = BufferPool::instance().checkout();
+        if (!lease)
+                return makeBad<std::streamsize>("Failed to map i/o buffer");
+        const auto size = std::min<size_t>(lease.size(),
+            std::numeric_limits<std::uint32_t>::max());
+        block_.resize(HEADER + bound(size));
+        const auto start = outOff;
+        while (len) {
+                const auto use = std::min<std::streamsize>(size, len);
+                const auto read = in.readAt(lease.data(), use, off);
+                if (!read)
+                        return makeBad<std::streamsize>(read.error());
+                if (*read != use)
+                        return makeBad<std::streamsize>("Input shrank: "
+                            + in.path());
+                if (sha)
+                        sha->update(lease.data(), use);
+                const auto packed = compress(lease.data(), use,
+                    block_.data() + HEADER, block_.size() - HEADER);
+                if (!packed)
+                        return makeBad<std::streamsize>(packed.error());
+                const bool shrank = *packed < static_cast<size_t>(use);
+                putU32(block_.data(), use);
+                putU32(block_.data() + 4, shrank ? *packed : 0);
+                if (const auto e = out.writeVec({
+                    { block_.data(), HEADER },
+                    { shrank ? block_.data() + HEADER : lease.data(),
+                        shrank ? *packed : static_cast<size_t>(use) },
+                    }, outOff))
+                        return makeBad<std::streamsize>(*e);
+                outOff += HEADER + (shrank ? *packed : use);
+                off += use;
+                len -= use;
+        }
+        return outOff - start;
+}
+
+/// expands a whole packed stripe into out at outOff, returns raw bytes.
+/// sparse leaves all zero blocks unwritten in an output sized upfront.
+Maybe<std::streamsize> Codec::unpack(const FileDesc& in,
+    const std::streamsize stored, const FileDesc& out, const off_t outOff,
+    const bool sparse)
+{
+        std::streamsize raw = 0;
+        char header[HEADER];
+        for (off_t at = 0; at < stored; ) {
+                if (stored - at < static_cast<off_t>(HEADER))
+                        return makeBad<std::streamsize>("Corrupt stripe: "
+                            + in.path());
+                const auto h = in.readAt(header, HEADER, at);
+                if (!h)
+                        return makeBad<std::streamsize>(h.error());
+                const auto rawLen = getU32(header);
+                const auto packed = getU32(header + 4);
+                const auto data = packed ? packed : rawLen;
+                at += HEADER;
+                if (stored - at < data)
+                        return makeBad<std::streamsize>("Corrupt stripe: "
+                            + in.path());
+                block_.resize(data);
+                if (const auto e = in.readVec({ { block_.data(), data } },
+                    at))
+                        return makeBad<std::streamsize>(*e);
+                const char* bytes = block_.data();
+                if (packed) {
+                        raw_.resize(rawLen);
+                        if (const auto e = decompress(block_.data(), packed,
+                            raw_.data(), rawLen))
+                                return makeBad<std::streamsize>(*e + ": "
+                                    + in.path());
+                        bytes = raw_.data();
+                }
+                if (!sparse || !scan::zero(bytes, rawLen))
+                        if (const auto e = out.writeAt(bytes, rawLen,
+                            outOff + raw))
+                                return makeBad<std::streamsize>(*e);
+                at += data;
+                raw += rawLen;
+        }
+        return raw;
+}
+
+/// one pass over the headers, no block data is read
+Maybe<BlockIndex> BlockIndex::build(const FileDesc& in,
+    const std::streamsize stored)
+{
+        BlockIndex index;
+        char header[Codec::HEADER];
+        off_t raw = 0;
+        for (off_t at = 0; at < stored; ) {
+                if (stored - at < static_cast<off_t>(Codec::HEADER))
+                        return makeBad<BlockIndex>("Corrupt stripe: "
+                            + in.path());
+                const auto h = in.readAt(header, Codec::HEADER, at);
+                if (!h)
+                        return makeBad<BlockIndex>(h.error());
+                if (*h != static_cast<std::streamsize>(Codec::HEADER))
+                        return makeBad<BlockIndex>("Stripe too short: "
+                            + in.path());
+                const off_t rawLen = getU32(header);
+                const off_t packed = getU32(header + 4);
+                const auto data = packed ? packed : rawLen;
+                if (stored - at - static_cast<off_t>(Codec::HEADER) < data)
+                        return makeBad<BlockIndex>("Corrupt stripe: "
+                            + in.path());
+                index.at.push_back(at);
+                index.raw.push_back(raw);
+                at += Codec::HEADER + data;
+                raw += rawLen;
+        }
+        index.raw.push_back(raw);
+        return index;
+}
+
+Maybe<std::shared_ptr<const BlockIndex>> BlockIndexes::get(
+    const FileDesc& in, const std::streamsize stored)
+{
+        using Ptr = std::shared_ptr<const BlockIndex>;
+        {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (const auto it = map_.find(in.path()); it != map_.end())
+                        return it->second;
+        }
+        /// built outside the lock, a race only builds one twice
+        auto index = BlockIndex::build(in, stored);
+        if (!index)
+                return makeBad<Ptr>(index.error());
+        std::lock_guard<std::mutex> lock(mtx_);
+        return map_.emplace(in.path(), std::make_shared<const BlockIndex>(
+            index.extract())).first->second;
+}
+
+/// Raw bytes [skip, skip + length) of a packed stripe into dst. The index
+/// points straight at the first block holding skip.
+Error Codec::extract(const FileDesc& in, const BlockIndex& index,
+    const off_t skip, const std::streamsize length, char* dst)
+{
+        const off_t end = skip + length;
+        if (end > index.raw.back())
+                return "Stripe too short: " + in.path();
+        char header[HEADER];
+        auto b = std::upper_bound(index.raw.begin(), index.raw.end() - 1,
+            skip) - index.raw.begin() - 1;
+        for (; b < static_cast<off_t>(index.at.size())
+            && index.raw[b] < end; b++) {
+                const auto at = index.at[b];
+                const auto raw = index.raw[b];
+                const auto h = in.readAt(header, HEADER, at);
+                if (!h)
+                        return h.error();
+                const off_t rawLen = getU32(header);
+                const auto packed = getU32(header + 4);
+                const auto data = packed ? packed : rawLen;
+                block_.resize(data);
+                if (const auto e = in.readVec({ { block_.data(),
+                    static_cast<size_t>(data) } }, at + HEADER))
+                        return e;
+                const char* bytes = block_.data();
+                if (packed) {
+                        raw_.resize(rawLen);
+                        if (const auto e = decompress(block_.data(), packed,
+                            raw_.data(), rawLen))
+                                return *e + ": " + in.path();
+                        bytes = raw_.data();
+                }
+                const auto from = std::max(skip, raw);
+                const auto to = std::min(end, raw + rawLen);
+                std::copy(bytes + (from - raw), bytes + (to - raw),
+                    dst + (from - skip));
+        }
+        return NONE;
+}
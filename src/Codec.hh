@@ -0,0 +1,92 @@
+/**
+ * File: Codec.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CODEC_HH
+#define CODEC_HH
+
+#include "src/FileDesc.hh"
+#include "src/Maybe.hh"
+#include "src/types.hh"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Sha256;
+
+enum class CodecKind { NONE, ZSTD, LZ4, ZLIB };
+
+/// --compress zstd|lz4|zlib[:level], the level 0 picks the codec default
+struct Compression {
+        CodecKind kind = CodecKind::NONE;
+        int level = 0;
+        static Maybe<Compression> parse(const std::string& spec);
+        std::string str() const;
+        explicit operator bool() const;
+};
+
+/// where every block of a packed stripe starts, so a range is found without
+/// walking the headers in front of it
+struct BlockIndex {
+        std::vector<off_t> at;  /// header offset in the stripe
+        std::vector<off_t> raw; /// first raw byte, plus the total at the end
+        static Maybe<BlockIndex> build(const FileDesc& in,
+            const std::streamsize stored);
+};
+
+/// block indexes by stripe path, built once and shared between threads
+class BlockIndexes {
+private:
+        std::mutex mtx_;
+        std::unordered_map<std::string, std::shared_ptr<const BlockIndex>>
+            map_;
+public:
+        Maybe<std::shared_ptr<const BlockIndex>> get(const FileDesc& in,
+            const std::streamsize stored);
+};
+
+/// Block compressor for one thread. A compressed stripe is a run of blocks,
+/// each one an 8 byte header (raw length, stored length, both u32 little
+/// endian) followed by the data. A stored length of 0 means the block did
+/// not shrink and its raw bytes follow.
+class Codec {
+private:
+        std::vector<char> block_;
+        std::vector<char> raw_;
+protected:
+        virtual size_t bound(const size_t n) const = 0;
+        virtual Maybe<size_t> compress(const char* src, const size_t n,
+            char* dst, const size_t cap) = 0;
+        virtual Error decompress(const char* src, const size_t n, char* dst,
+            const size_t raw) = 0;
+public:
+        static constexpr size_t HEADER = 8;
+        Codec() = default;
+        virtual ~Codec() = default;
+        Codec(const Codec&) = delete;
+        static Maybe<std::unique_ptr<Codec>> create(const Compression& c);
+        Maybe<std::streamsize> pack(const FileDesc& in, off_t off,
+            std::streamsize len, const FileDesc& out, off_t outOff,
+            Sha256* sha = nullptr);
+        Maybe<std::streamsize> unpack(const FileDesc& in,
+            const std::streamsize stored, const FileDesc& out,
+            const off_t outOff, const bool sparse = false);
+        Error extract(const FileDesc& in, const BlockIndex& index,
+            const off_t skip, const std::streamsize length, char* dst);
+};
+
+#endif /// CODEC_HH
@@ -0,0 +1,101 @@
+/**
+ * File: Crc32.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Crc32.hh"
+#include <array>
+
+namespace {
+
+/// slicing by 8, table k advances a byte k positions further
+using Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr Tables makeTables()
+{
+        Tables t{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+                auto c = i;
+                for (int k = 0; k < 8; k++)
+                        c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+                t[0][i] = c;
+        }
+        for (std::uint32_t i = 0; i < 256; i++)
+                for (size_t k = 1; k < 8; k++)
+                        t[k][i] = (t[k - 1][i] >> 8)
+                            ^ t[0][t[k - 1][i] & 0xff];
+        return t;
+}
+
+constexpr Tables T = makeTables();
+
+/// a times b modulo the polynomial, both reflected
+constexpr std::uint32_t multiply(std::uint32_t a, std::uint32_t b)
+{
+        std::uint32_t m = 1u << 31;
+        std::uint32_t p = 0;
+        for (;;) {
+                if (a & m) {
+                        p ^= b;
+                        if ((a & (m - 1)) == 0)
+                                break;
+                }
+                m >>= 1;
+                b = b & 1 ? 0xedb88320 ^ (b >> 1) : b >> 1;
+        }
+        return p;
+}
+
+/// x^(2^k) for every k
+constexpr std::array<std::uint32_t, 32> makePowers()
+{
+        std::array<std::uint32_t, 32> x{};
+        x[0] = 1u << 30;
+        for (size_t k = 1; k < x.size(); k++)
+                x[k] = multiply(x[k - 1], x[k - 1]);
+        return x;
+}
+
+constexpr auto X2N = makePowers();
+
+} /// namespace
+
+std::uint32_t crc32::update(std::uint32_t crc, const char* p, size_t n)
+{
+        const auto* s = reinterpret_cast<const unsigned char*>(p);
+        crc = ~crc;
+        for (; n >= 8; n -= 8, s += 8) {
+                const std::uint32_t lo = (s[0] | s[1] << 8 | s[2] << 16
+                    | std::uint32_t(s[3]) << 24) ^ crc;
+                const std::uint32_t hi = s[4] | s[5] << 8 | s[6] << 16
+                    | std::uint32_t(s[7]) << 24;
+                crc = T[7][lo & 0xff] ^ T[6][(lo >> 8) & 0xff]
+                    ^ T[5][(lo >> 16) & 0xff] ^ T[4][lo >> 24]
+                    ^ T[3][hi & 0xff] ^ T[2][(hi >> 8) & 0xff]
+                    ^ T[1][(hi >> 16) & 0xff] ^ T[0][hi >> 24];
+        }
+        for (; n; n--, s++)
+                crc = T[0][(crc ^ *s) & 0xff] ^ (crc >> 8);
+        return ~crc;
+}
+
+/// zero bytes only shift the register, that is a multiplication by x^8n
+std::uint32_t crc32::zeros(std::uint32_t crc, std::uint64_t n)
+{
+        std::uint32_t shift = 1u << 31;
+        for (size_t k = 3; n; n >>= 1, k++)
+                if (n & 1)
+                        shift = multiply(X2N[k & 31], shift);
+        return ~multiply(shift, ~crc);
+}
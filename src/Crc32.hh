@@ -0,0 +1,33 @@
+/**
+ * File: Crc32.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CRC32_HH
+#define CRC32_HH
+
+#include <cstddef>
+#include <cstdint>
+
+/// CRC-32 (IEEE, as zlib and gzip), fed incrementally from 0.
+namespace crc32 {
+
+std::uint32_t update(std::uint32_t crc, const char* p, size_t n);
+
+/// as if n zero bytes were fed, in log n steps
+std::uint32_t zeros(std::uint32_t crc, std::uint64_t n);
+
+} /// crc32
+
+#endif /// CRC32_HH
@@ -0,0 +1,123 @@
+/**
+ * File: Durability.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Durability.hh"
+#include "src/consts.hh"
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+Durability::Durability(const SyncMode mode)
+    : mode_(mode)
+{
+        if (mode_ == SyncMode::BATCH)
+                flusher_ = std::thread(&Durability::flush, this);
+}
+
+Durability::~Durability()
+{
+        {
+                std::lock_guard<std::mutex> lock(mtx_);
+                done_ = true;
+        }
+        cv_.notify_all();
+        if (flusher_.joinable())
+                flusher_.join();
+}
+
+void Durability::timed(const Clock::time_point& begin)
+{
+        const auto d = Clock::now() - begin;
+        nanos_ += std::chrono::duration_cast<std::chrono::nanoseconds>(d)
+            .count();
+}
+
+void Durability::flush()
+{
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true) {
+                cv_.wait(lock, [this] { return done_ || !queue_.empty(); });
+                if (queue_.empty())
+                        return;
+                auto file = std::move(queue_.front());
+                queue_.pop_front();
+                lock.unlock();
+                auto e = file.sync();
+                if (!e)
+                        e = file.close();
+                lock.lock();
+                if (e && err_.empty())
+                        err_ = *e;
+        }
+}
+
+Error Durability::settle(FileDesc&& file)
+{
+        switch (mode_) {
+        case SyncMode::EACH : {
+                const auto begin = Clock::now();
+                const auto e = file.sync();
+                timed(begin);
+                if (e)
+                        return e;
+                break;
+        }
+        case SyncMode::BATCH : {
+                {
+                        std::lock_guard<std::mutex> lock(mtx_);
+                        queue_.push_back(std::move(file));
+                }
+                cv_.notify_one();
+                return NONE;
+        }
+        default :
+                break;
+        }
+        return file.close();
+}
+
+Error Durability::finish(const std::vector<std::string>& dirs)
+{
+        if (mode_ == SyncMode::NONE)
+                return NONE;
+        const auto begin = Clock::now();
+        {
+                std::lock_guard<std::mutex> lock(mtx_);
+                done_ = true;
+        }
+        cv_.notify_all();
+        if (flusher_.joinable())
+                flusher_.join();
+        if (!err_.empty())
+                return err_;
+        for (const auto& dir : dirs) {
+                const auto d = FileDesc::openRead(dir);
+                if (!d)
+                        return d.error();
+                if (mode_ != SyncMode::EACH)
+                        if (const auto e = d->syncFs())
+                                return e;
+                if (const auto e = d->sync())
+                        return e;
+        }
+        timed(begin);
+        return NONE;
+}
+
+double Durability::millis() const
+{
+        return nanos_ / 1e6;
+}
@@ -0,0 +1,58 @@
+/**
+ * File: Durability.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef DURABILITY_HH
+#define DURABILITY_HH
+
+#include "src/FileDesc.hh"
+#include "src/IOPolicy.hh"
+#include "src/types.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Makes finished outputs durable according to IOPolicy::sync.
+/// NONE:  nothing
+/// END:   one syncfs and a directory fsync in finish
+/// EACH:  fsync as every file settles, directory fsync in finish
+/// BATCH: a flusher thread fsyncs settled files in the background,
+///        finish drains it then does END
+class Durability {
+private:
+        const SyncMode mode_;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::deque<FileDesc> queue_;
+        std::thread flusher_;
+        bool done_ = false;
+        std::string err_;
+        std::atomic<long long> nanos_ = 0;
+        void flush();
+        void timed(const std::chrono::steady_clock::time_point& begin);
+public:
+        explicit Durability(const SyncMode mode);
+        ~Durability();
+        Durability(const Durability&) = delete;
+        Error settle(FileDesc&& file);
+        Error finish(const std::vector<std::string>& dirs);
+        double millis() const;
+};
+
+#endif /// DURABILITY_HH
@@ -0,0 +1,285 @@
+/**
+ * File: FileDesc.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/FileDesc.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+FileDesc::FileDesc(const int fd, const std::string& path)
+    : fd_(fd)
+    , path_(path)
+{ }
+
+FileDesc::~FileDesc()
+{
+        if (fd_ != -1)
+                ::close(fd_);
+}
+
+FileDesc::FileDesc(FileDesc&& other) noexcept
+    : fd_(other.fd_)
+    , path_(std::move(other.path_))
+{
+        other.fd_ = -1;
+}
+
+FileDesc& FileDesc::operator=(FileDesc&& other) noexcept
+{
+        if (this != &other) {
+                if (fd_ != -1)
+                        ::close(fd_);
+                fd_ = other.fd_;
+                path_ = std::move(other.path_);
+                other.fd_ = -1;
+        }
+        return *this;
+}
+
+Maybe<FileDesc> FileDesc::openFlags(const std::string& path, const int flags)
+{
+        int fd;
+        do {
+                fd = ::open(path.c_str(), flags | O_CLOEXEC, 0666);
+        } while (fd == -1 && errno == EINTR);
+        if (fd == -1)
+                return makeBad<FileDesc>(util::sysError("Failed to open",
+                    path));
+        return FileDesc(fd, path);
+}
+
+Maybe<FileDesc> FileDesc::openRead(const std::string& path)
+{
+        return openFlags(path, O_RDONLY);
+}
+
+Maybe<FileDesc> FileDesc::openWrite(const std::string& path)
+{
+        return openFlags(path, O_WRONLY | O_CREAT | O_TRUNC);
+}
+
+Maybe<FileDesc> FileDesc::openUpdate(const std::string& path)
+{
+        return openFlags(path, O_WRONLY | O_CREAT);
+}
+
+FileDesc::operator bool() const
+{
+        return fd_ != -1;
+}
+
+int FileDesc::get() const
+{
+        return fd_;
+}
+
+const std::string& FileDesc::path() const
+{
+        return path_;
+}
+
+Maybe<std::streamsize> FileDesc::size() const
+{
+        struct stat st;
+        if (::fstat(fd_, &st) == -1)
+                return makeBad<std::streamsize>(util::sysError("stat", path_));
+        return static_cast<std::streamsize>(st.st_size);
+}
+
+Maybe<std::streamsize> FileDesc::allocated() const
+{
+        struct stat st;
+        if (::fstat(fd_, &st) == -1)
+                return makeBad<std::streamsize>(util::sysError("stat", path_));
+        return static_cast<std::streamsize>(st.st_blocks) * 512;
+}
+
+Maybe<std::streamsize> FileDesc::readAt(char* buf, std::streamsize len,
+    off_t off) const
+{
+        std::streamsize acc = 0;
+        while (len) {
+                const auto r = ::pread(fd_, buf + acc, len, off + acc);
+                if (r == -1 && errno == EINTR)
+                        continue;
+                if (r == -1)
+                        return makeBad<std::streamsize>(
+                            util::sysError("Read failed", path_));
+                if (r == 0)
+                        break;
+                acc += r;
+                len -= r;
+        }
+        return acc;
+}
+
+Error FileDesc::writeAt(const char* buf, std::streamsize len, off_t off) const
+{
+        std::streamsize acc = 0;
+        while (len) {
+                const auto w = ::pwrite(fd_, buf + acc, len, off + acc);
+                if (w == -1 && errno == EINTR)
+                        continue;
+                if (w == -1)
+                        return util::sysError("Write failed", path_);
+                acc += w;
+                len -= w;
+        }
+        return NONE;
+}
+
+namespace {
+
+/// drops the first n transferred bytes from the front of iov
+size_t advance(std::vector<iovec>& iov, size_t first, size_t n)
+{
+        while (n && first < iov.size()) {
+                auto& v = iov[first];
+                const auto use = std::min(n, v.iov_len);
+                v.iov_base = static_cast<char*>(v.iov_base) + use;
+                v.iov_len -= use;
+                n -= use;
+                if (!v.iov_len)
+                        first++;
+        }
+        return first;
+}
+
+} /// namespace
+
+/// Whole iov is filled from off onward, short reads past the end of the
+/// file are an error since callers always know the exact layout.
+Error FileDesc::readVec(std::vector<iovec> iov, off_t off) const
+{
+        size_t first = 0;
+        while (first < iov.size()) {
+                const int cnt = std::min<size_t>(iov.size() - first, IOV_MAX);
+                const auto r = ::preadv(fd_, iov.data() + first, cnt, off);
+                if (r == -1 && errno == EINTR)
+                        continue;
+                if (r == -1)
+                        return util::sysError("Read failed", path_);
+                if (r == 0)
+                        return "Unexpected end of file: " + path_;
+                off += r;
+                first = advance(iov, first, r);
+        }
+        return NONE;
+}
+
+Error FileDesc::writeVec(std::vector<iovec> iov, off_t off) const
+{
+        size_t first = 0;
+        while (first < iov.size()) {
+                const int cnt = std::min<size_t>(iov.size() - first, IOV_MAX);
+                const auto w = ::pwritev(fd_, iov.data() + first, cnt, off);
+                if (w == -1 && errno == EINTR)
+                        continue;
+                if (w == -1)
+                        return util::sysError("Write failed", path_);
+                off += w;
+                first = advance(iov, first, w);
+        }
+        return NONE;
+}
+
+/// In kernel copy, reflinked where the filesystem can. Returns how much was
+/// copied before the kernel refused, the caller copies the rest itself.
+Maybe<std::streamsize> FileDesc::copyFrom(const FileDesc& in, off_t inOff,
+    off_t off, std::streamsize len) const
+{
+        std::streamsize acc = 0;
+        while (len) {
+                const auto c = ::copy_file_range(in.get(), &inOff, fd_, &off,
+                    len, 0);
+                if (c == -1 && errno == EINTR)
+                        continue;
+                if (c == -1 && (errno == EXDEV || errno == EINVAL
+                    || errno == ENOSYS || errno == EOPNOTSUPP))
+                        break;
+                if (c == -1)
+                        return makeBad<std::streamsize>(
+                            util::sysError("Copy failed", in.path()));
+                if (c == 0)
+                        break;
+                acc += c;
+                len -= c;
+        }
+        return acc;
+}
+
+/// sparse only sets the size, every block is a hole until written
+Error FileDesc::allocate(const off_t len, const bool sparse) const
+{
+        if (len <= 0)
+                return NONE;
+        if (sparse) {
+                if (::ftruncate(fd_, len) == -1)
+                        return util::sysError("Failed to resize", path_);
+                return NONE;
+        }
+        int r;
+        do {
+                r = ::fallocate(fd_, 0, 0, len);
+        } while (r == -1 && errno == EINTR);
+        /// filesystems without fallocate just lose the layout hint
+        if (r == -1 && errno != EOPNOTSUPP && errno != ENOSYS)
+                return util::sysError("Failed to allocate", path_);
+        return NONE;
+}
+
+/// grows the file to len, never shrinks it
+Error FileDesc::extend(const off_t len) const
+{
+        const auto size = this->size();
+        if (!size)
+                return size.error();
+        if (*size >= len)
+                return NONE;
+        if (::ftruncate(fd_, len) == -1)
+                return util::sysError("Failed to resize", path_);
+        return NONE;
+}
+
+Error FileDesc::sync() const
+{
+        if (::fsync(fd_) == -1)
+                return util::sysError("fsync", path_);
+        return NONE;
+}
+
+Error FileDesc::syncFs() const
+{
+        if (::syncfs(fd_) == -1)
+                return util::sysError("syncfs", path_);
+        return NONE;
+}
+
+Error FileDesc::close()
+{
+        if (fd_ == -1)
+                return NONE;
+        const auto fd = fd_;
+        fd_ = -1;
+        if (::close(fd) == -1 && errno != EINTR)
+                return util::sysError("Close failed", path_);
+        return NONE;
+}
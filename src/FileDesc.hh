@@ -0,0 +1,66 @@
+/**
+ * File: FileDesc.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef FILE_DESC_HH
+#define FILE_DESC_HH
+
+#include "src/Maybe.hh"
+#include "src/types.hh"
+#include <string>
+#include <ios>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/// Owning POSIX file descriptor. All data i/o is positional so a single
+/// descriptor can be shared between threads.
+class FileDesc {
+private:
+        int fd_ = -1;
+        std::string path_;
+        static Maybe<FileDesc> openFlags(const std::string& path,
+            const int flags);
+public:
+        FileDesc() = default;
+        FileDesc(const int fd, const std::string& path);
+        ~FileDesc();
+        FileDesc(const FileDesc&) = delete;
+        FileDesc(FileDesc&& other) noexcept;
+        FileDesc& operator=(FileDesc&& other) noexcept;
+        static Maybe<FileDesc> openRead(const std::string& path);
+        static Maybe<FileDesc> openWrite(const std::string& path);
+        static Maybe<FileDesc> openUpdate(const std::string& path);
+        explicit operator bool() const;
+        int get() const;
+        const std::string& path() const;
+        Maybe<std::streamsize> size() const;
+        /// bytes of disk the file holds, holes excluded
+        Maybe<std::streamsize> allocated() const;
+        Maybe<std::streamsize> readAt(char* buf, std::streamsize len,
+            off_t off) const;
+        Error writeAt(const char* buf, std::streamsize len, off_t off) const;
+        Error readVec(std::vector<iovec> iov, off_t off) const;
+        Error writeVec(std::vector<iovec> iov, off_t off) const;
+        Maybe<std::streamsize> copyFrom(const FileDesc& in, off_t inOff,
+            off_t off, std::streamsize len) const;
+        Error allocate(const off_t len, const bool sparse = false) const;
+        Error extend(const off_t len) const;
+        Error sync() const;
+        Error syncFs() const;
+        Error close();
+};
+
+#endif /// FILE_DESC_HH
@@ -15,24 +15,165 @@
  */
 
 #include "src/IOBuffer.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include "src/Crc32.hh"
+#include "src/scan.hh"
+#include "src/Sha256.hh"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
-IOBuffer::IOBuffer()
-    : buffer_(size_, 0)
-{ }
+namespace {
 
-std::streamsize IOBuffer::chunk(std::ifstream& input, std::ofstream& output,
-    std::streamsize remaining)
+/// [data, hole) of the next allocated extent at or after pos. Filesystems
+/// that cannot tell report everything as data.
+std::pair<off_t, off_t> extent(const FileDesc& file, const off_t pos,
+    const off_t size)
+{
+        const auto data = ::lseek(file.get(), pos, SEEK_DATA);
+        if (data == -1)
+                return errno == ENXIO ? std::pair(size, size)
+                                      : std::pair(pos, size);
+        const auto hole = ::lseek(file.get(), data, SEEK_HOLE);
+        return { data, hole == -1 ? size : hole };
+}
+
+/// a skipped hole still counts toward a digest of the data
+void zeros(Sha256& sha, std::streamsize n)
+{
+        static const char zero[4'096] = {};
+        for (; n > 0; n -= sizeof(zero))
+                sha.update(zero, std::min<std::streamsize>(n, sizeof(zero)));
+}
+
+} /// namespace
+
+/// Starts writeback of [flushed, done), then waits on the previous window
+/// and drops it from the page cache on both sides.
+Error IOBuffer::writeBehind(const FileDesc& input, off_t inOff,
+    const FileDesc& output, off_t outOff, off_t& dropped, off_t& flushed,
+    const off_t done) const
+{
+        const auto out = output.get();
+        if (done > flushed && ::sync_file_range(out, outOff + flushed,
+            done - flushed, SYNC_FILE_RANGE_WRITE) == -1)
+                return util::sysError("sync_file_range", output.path());
+        if (flushed > dropped) {
+                const auto len = flushed - dropped;
+                constexpr auto wait = SYNC_FILE_RANGE_WAIT_BEFORE
+                    | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+                if (::sync_file_range(out, outOff + dropped, len, wait) == -1)
+                        return util::sysError("sync_file_range",
+                            output.path());
+                ::posix_fadvise(out, outOff + dropped, len,
+                    POSIX_FADV_DONTNEED);
+                ::posix_fadvise(input.get(), inOff + dropped, len,
+                    POSIX_FADV_DONTNEED);
+                dropped = flushed;
+        }
+        flushed = done;
+        return NONE;
+}
+
+Maybe<std::streamsize> IOBuffer::chunk(const FileDesc& input, off_t inOff,
+    const FileDesc& output, off_t outOff, std::streamsize remaining,
+    const IOPolicy& io, std::uint32_t* crc, Sha256* sha)
+{
+        std::streamsize acc = 0;
+        off_t dropped = 0;
+        off_t flushed = 0;
+        if (!buffer_)
+                buffer_ = BufferPool::instance().checkout();
+        if (!buffer_)
+                return makeBad<std::streamsize>("Failed to map i/o buffer");
+        if (io.streaming)
+                ::posix_fadvise(input.get(), inOff, remaining,
+                    POSIX_FADV_SEQUENTIAL);
+        /// --sparse: holes are skipped without reading them, the output was
+        /// sized upfront so what is not written stays a hole there too
+        const auto size = io.sparse ? input.size()
+                                    : Maybe<std::streamsize>(0);
+        if (!size)
+                return makeBad<std::streamsize>(size.error());
+        std::pair<off_t, off_t> data = { 0, 0 };
+        while (remaining) {
+                auto use = std::min(buffer_.size(), remaining);
+                if (io.sparse) {
+                        const off_t at = inOff + acc;
+                        if (at >= data.second)
+                                data = extent(input, at, *size);
+                        if (data.first > at) {
+                                const auto hole = std::min<std::streamsize>(
+                                    std::min<off_t>(data.first, *size) - at,
+                                    remaining);
+                                if (hole <= 0)
+                                        break;
+                                if (crc)
+                                        *crc = crc32::zeros(*crc, hole);
+                                if (sha)
+                                        zeros(*sha, hole);
+                                acc += hole;
+                                remaining -= hole;
+                                continue;
+                        }
+                        use = std::min<std::streamsize>(use,
+                            data.second - at);
+                }
+                const auto read = input.readAt(buffer_.data(), use,
+                    inOff + acc);
+                if (!read)
+                        return makeBad<std::streamsize>(read.error());
+                if (!*read)
+                        break;
+                if (crc)
+                        *crc = crc32::update(*crc, buffer_.data(), *read);
+                if (sha)
+                        sha->update(buffer_.data(), *read);
+                const bool skip = io.sparse
+                    && scan::zero(buffer_.data(), *read);
+                if (!skip)
+                        if (const auto e = output.writeAt(buffer_.data(),
+                            *read, outOff + acc))
+                                return makeBad<std::streamsize>(*e);
+                acc += *read;
+                remaining -= *read;
+                if (io.streaming && acc - flushed >= io.window) {
+                        if (const auto e = writeBehind(input, inOff, output,
+                            outOff, dropped, flushed, acc))
+                                return makeBad<std::streamsize>(*e);
+                }
+        }
+        if (io.streaming) {
+                /// second pass waits on and drops the final window
+                for (int i = 0; i < 2; i++)
+                        if (const auto e = writeBehind(input, inOff, output,
+                            outOff, dropped, flushed, acc))
+                                return makeBad<std::streamsize>(*e);
+        }
+        return acc;
+}
+
+/// reads a range only to hash it, returns the bytes hashed
+Maybe<std::streamsize> IOBuffer::digest(const FileDesc& input, off_t inOff,
+    std::streamsize remaining, Sha256& sha)
 {
         std::streamsize acc = 0;
+        if (!buffer_)
+                buffer_ = BufferPool::instance().checkout();
+        if (!buffer_)
+                return makeBad<std::streamsize>("Failed to map i/o buffer");
         while (remaining) {
-                const auto use = std::min(size_, remaining);
-                input.read(buffer_.data(), use);
-                const auto& read = input.gcount();
+                const auto read = input.readAt(buffer_.data(),
+                    std::min(buffer_.size(), remaining), inOff + acc);
                 if (!read)
+                        return makeBad<std::streamsize>(read.error());
+                if (!*read)
                         break;
-                acc += read;
-                output.write(buffer_.data(), read);
-                remaining -= use;
+                sha.update(buffer_.data(), *read);
+                acc += *read;
+                remaining -= *read;
         }
         return acc;
 }
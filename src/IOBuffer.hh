@@ -17,23 +17,36 @@
 #ifndef IO_BUFFER_HH
 #define IO_BUFFER_HH
 
-#include <fstream>
-#include <vector>
+#include "src/FileDesc.hh"
+#include "src/Maybe.hh"
+#include "src/IOPolicy.hh"
+#include "src/BufferPool.hh"
+#include <cstdint>
+#include <sys/types.h>
 
 class UtilStripeBase;
+class AssemblerIO;
+class Sha256;
 
 class IOBuffer {
 private:
-        const std::streamsize size_ = 1'024 * 64;
-        std::vector<char> buffer_;
+        BufferPool::Lease buffer_;
+        Error writeBehind(const FileDesc& input, off_t inOff,
+            const FileDesc& output, off_t outOff, off_t& dropped,
+            off_t& flushed, const off_t done) const;
 protected:
-        std::streamsize chunk(std::ifstream& input, std::ofstream& output,
-            std::streamsize remaining);
+        Maybe<std::streamsize> chunk(const FileDesc& input, off_t inOff,
+            const FileDesc& output, off_t outOff, std::streamsize remaining,
+            const IOPolicy& io, std::uint32_t* crc = nullptr,
+            Sha256* sha = nullptr);
+        Maybe<std::streamsize> digest(const FileDesc& input, off_t inOff,
+            std::streamsize remaining, Sha256& sha);
 public:
-        IOBuffer();
+        IOBuffer() = default;
         virtual ~IOBuffer() = default;
         IOBuffer(const IOBuffer&) = delete;
         friend class UtilStripeBase;
+        friend class AssemblerIO;
 };
 
 #endif /// IO_BUFFER_HH
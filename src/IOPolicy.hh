@@ -0,0 +1,36 @@
+/**
+ * File: IOPolicy.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef IO_POLICY_HH
+#define IO_POLICY_HH
+
+#include <ios>
+#include <cstddef>
+
+enum class SyncMode { NONE, END, EACH, BATCH };
+
+/// Page cache and durability behaviour shared by every data copy.
+struct IOPolicy {
+        bool streaming = false;
+        std::streamsize window = 1'024 * 1'024 * 8;
+        SyncMode sync = SyncMode::NONE;
+        size_t bufferSize = 1'024 * 64;
+        size_t maxMemory = 0;
+        bool hugePages = false;
+        bool sparse = false; /// holes and zero blocks are not written
+};
+
+#endif /// IO_POLICY_HH
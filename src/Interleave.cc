@@ -0,0 +1,195 @@
+/**
+ * File: Interleave.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Interleave.hh"
+#include "src/consts.hh"
+#include "src/BufferPool.hh"
+#include "src/Failure.hh"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+Interleave::Interleave(const size_t n, const std::streamsize unit,
+    const std::streamsize total)
+    : n_(n)
+    , unit_(unit)
+    , total_(total)
+{ }
+
+size_t Interleave::files() const
+{
+        return n_;
+}
+
+size_t Interleave::blocks() const
+{
+        return (total_ + unit_ - 1) / unit_;
+}
+
+std::streamsize Interleave::unit() const
+{
+        return unit_;
+}
+
+std::streamsize Interleave::total() const
+{
+        return total_;
+}
+
+std::streamsize Interleave::fileSize(const size_t file) const
+{
+        const auto b = blocks();
+        if (file >= b)
+                return 0;
+        const auto count = (b - file + n_ - 1) / n_;
+        const auto last = file + (count - 1) * n_;
+        const auto tail = std::min(unit_, total_ - static_cast<off_t>(last)
+            * unit_);
+        return (count - 1) * unit_ + tail;
+}
+
+/// Window holds source blocks [first, first + count). Returns the pieces of
+/// it that belong to one file, they are contiguous in that file from `at`.
+std::vector<iovec> Interleave::blocks(char* window, const size_t first,
+    const size_t count, const size_t file, off_t& at) const
+{
+        std::vector<iovec> iov;
+        auto b = first + (file + n_ - first % n_) % n_;
+        at = static_cast<off_t>(b / n_) * unit_;
+        for (; b < first + count; b += n_) {
+                const auto len = std::min(unit_, total_ - static_cast<off_t>(b)
+                    * unit_);
+                iov.push_back({ window + (b - first) * unit_,
+                    static_cast<size_t>(len) });
+        }
+        return iov;
+}
+
+Error Interleave::scatter(char* window, const size_t first,
+    const size_t count, const std::vector<FileDesc>& files) const
+{
+        for (size_t k = 0; k < n_; k++) {
+                off_t at = 0;
+                const auto iov = blocks(window, first, count, k, at);
+                if (!iov.empty())
+                        if (const auto e = files[k].writeVec(iov, at))
+                                return e;
+        }
+        return NONE;
+}
+
+Error Interleave::gather(char* window, const size_t first,
+    const size_t count, const std::vector<FileDesc>& files) const
+{
+        for (size_t k = 0; k < n_; k++) {
+                off_t at = 0;
+                const auto iov = blocks(window, first, count, k, at);
+                if (!iov.empty())
+                        if (const auto e = files[k].readVec(iov, at))
+                                return e;
+        }
+        return NONE;
+}
+
+/// blocks per window, a whole number of rows when the buffer allows it so
+/// every file gets one vectored call per window
+size_t Interleave::window(const std::streamsize buffer) const
+{
+        const auto fit = static_cast<size_t>(buffer / unit_);
+        return fit >= n_ ? fit / n_ * n_ : fit;
+}
+
+namespace {
+
+class Windows : protected Failure {
+private:
+        std::atomic<size_t> next_ = 0;
+public:
+        template <typename F>
+        Error run(const Interleave& layout, const int threads, F&& step);
+};
+
+/// threads claim windows in order until all blocks are moved
+template <typename F>
+Error Windows::run(const Interleave& layout, const int threads, F&& step)
+{
+        const auto size = BufferPool::instance().size();
+        const auto count = layout.window(size);
+        if (!count)
+                return "Unit larger than buffer size";
+        const auto blocks = layout.blocks();
+        const auto work = [&]() {
+                auto buffer = BufferPool::instance().checkout();
+                if (!buffer) {
+                        fail("Failed to map i/o buffer");
+                        return;
+                }
+                while (!failure_) {
+                        const auto first = next_++ * count;
+                        if (first >= blocks)
+                                return;
+                        const auto use = std::min(count, blocks - first);
+                        if (const auto e = step(buffer.data(), first, use)) {
+                                fail(*e);
+                                return;
+                        }
+                }
+        };
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; i++)
+                pool.emplace_back(work);
+        work();
+        for (auto& t : pool)
+                t.join();
+        if (failure_)
+                return fmsg_;
+        return NONE;
+}
+
+} /// namespace
+
+/// one contiguous read of the window, one pwritev per file
+Error Interleave::split(const FileDesc& source,
+    const std::vector<FileDesc>& files, const int threads) const
+{
+        Windows w;
+        return w.run(*this, threads, [&](char* buf, size_t first, size_t use) {
+                const off_t at = static_cast<off_t>(first) * unit_;
+                const auto len = std::min<std::streamsize>(use * unit_,
+                    total_ - at);
+                const auto read = source.readAt(buf, len, at);
+                if (!read)
+                        return Error(read.error());
+                if (*read != len)
+                        return Error("Input shrank: " + source.path());
+                return scatter(buf, first, use, files);
+        });
+}
+
+/// one preadv per file, one contiguous write of the window
+Error Interleave::join(const std::vector<FileDesc>& files,
+    const FileDesc& dest, const int threads) const
+{
+        Windows w;
+        return w.run(*this, threads, [&](char* buf, size_t first, size_t use) {
+                if (const auto e = gather(buf, first, use, files))
+                        return e;
+                const off_t at = static_cast<off_t>(first) * unit_;
+                const auto len = std::min<std::streamsize>(use * unit_,
+                    total_ - at);
+                return dest.writeAt(buf, len, at);
+        });
+}
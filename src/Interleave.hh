@@ -0,0 +1,54 @@
+/**
+ * File: Interleave.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef INTERLEAVE_HH
+#define INTERLEAVE_HH
+
+#include "src/FileDesc.hh"
+#include "src/IOPolicy.hh"
+#include "src/types.hh"
+#include <vector>
+
+/// RAID-0 style layout of a source over n files. Source block b of unit
+/// bytes lands in file b % n at offset (b / n) * unit.
+class Interleave {
+private:
+        size_t n_;
+        std::streamsize unit_;
+        std::streamsize total_;
+        std::vector<iovec> blocks(char* window, const size_t first,
+            const size_t count, const size_t file, off_t& at) const;
+public:
+        Interleave(const size_t n, const std::streamsize unit,
+            const std::streamsize total);
+        ~Interleave() = default;
+        size_t files() const;
+        size_t blocks() const;
+        std::streamsize unit() const;
+        std::streamsize total() const;
+        std::streamsize fileSize(const size_t file) const;
+        Error scatter(char* window, const size_t first, const size_t count,
+            const std::vector<FileDesc>& files) const;
+        Error gather(char* window, const size_t first, const size_t count,
+            const std::vector<FileDesc>& files) const;
+        size_t window(const std::streamsize buffer) const;
+        Error split(const FileDesc& source, const std::vector<FileDesc>& files,
+            const int threads) const;
+        Error join(const std::vector<FileDesc>& files, const FileDesc& dest,
+            const int threads) const;
+};
+
+#endif /// INTERLEAVE_HH
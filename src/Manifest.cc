@@ -0,0 +1,204 @@
+/**
+ * File: Manifest.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Manifest.hh"
+#include "src/FileDesc.hh"
+#include "src/consts.hh"
+#include "src/utils.hh"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <climits>
+#include <unistd.h>
+
+namespace {
+
+const std::string MAGIC = "zebra-manifest 1";
+
+Maybe<ManifestEntry> parseEntry(const std::string& line)
+{
+        ManifestEntry e;
+        size_t pos = line.find(' ');
+        while (pos != std::string::npos && pos + 1 < line.size()) {
+                const auto begin = pos + 1;
+                const auto eq = line.find('=', begin);
+                if (eq == std::string::npos)
+                        return makeBad<ManifestEntry>("Bad manifest: " + line);
+                const auto key = line.substr(begin, eq - begin);
+                if (key == "name") {
+                        e.name = line.substr(eq + 1);
+                        break;
+                }
+                pos = line.find(' ', eq);
+                const auto val = line.substr(eq + 1, pos - eq - 1);
+                try {
+                        if (key == "index")
+                                e.index = std::stoull(val);
+                        else if (key == "offset")
+                                e.offset = std::stoll(val);
+                        else if (key == "length")
+                                e.length = std::stoll(val);
+                        else if (key == "stored")
+                                e.stored = std::stoll(val);
+                        else if (key == "dir")
+                                e.dir = std::stoull(val);
+                } catch (const std::exception&) {
+                        return makeBad<ManifestEntry>("Bad manifest: " + line);
+                }
+        }
+        if (e.name.empty())
+                return makeBad<ManifestEntry>("Bad manifest: " + line);
+        return e;
+}
+
+} /// namespace
+
+std::string Manifest::fileName(const std::string& name)
+{
+        return (name.empty() ? "zebra" : name) + ".manifest";
+}
+
+/// manifest of the stripes finished so far in order, see --ordered
+std::string Manifest::readyName(const std::string& name)
+{
+        return (name.empty() ? "zebra" : name) + ".ready";
+}
+
+/// one participant's stripes of a --shard run
+std::string Manifest::shardName(const std::string& name, const size_t shard,
+    const size_t shards)
+{
+        return (name.empty() ? "zebra" : name) + ".shard-"
+            + std::to_string(shard) + "-of-" + std::to_string(shards);
+}
+
+Maybe<Manifest> Manifest::read(const std::string& path)
+{
+        std::ifstream in(path);
+        if (!in)
+                return makeBad<Manifest>(util::sysError("Failed to open",
+                    path));
+        std::string line;
+        if (!std::getline(in, line) || line != MAGIC)
+                return makeBad<Manifest>("Not a manifest: " + path);
+        Manifest m;
+        while (std::getline(in, line)) {
+                const auto sp = line.find(' ');
+                const auto key = line.substr(0, sp);
+                const auto rest = sp == std::string::npos ? ""
+                                                          : line.substr(sp + 1);
+                try {
+                        if (key == "source") {
+                                m.source = rest;
+                        } else if (key == "size") {
+                                m.size = std::stoll(rest);
+                        } else if (key == "interleave") {
+                                m.interleave = std::stoull(rest);
+                        } else if (key == "unit") {
+                                m.unit = std::stoll(rest);
+                        } else if (key == "compress") {
+                                m.compress = rest;
+                        } else if (key == "headers") {
+                                m.headers = rest == "1";
+                        } else if (key == "store") {
+                                m.store = rest == "1";
+                        } else if (key == "index-only") {
+                                m.indexOnly = rest == "1";
+                        } else if (key == "inode") {
+                                m.inode = std::stoull(rest);
+                        } else if (key == "mtime") {
+                                m.mtime = std::stoll(rest);
+                        } else if (key == "dir") {
+                                const auto dsp = rest.find(' ');
+                                const auto i = std::stoull(rest.substr(0, dsp));
+                                if (m.dirs.size() <= i)
+                                        m.dirs.resize(i + 1);
+                                m.dirs[i] = rest.substr(dsp + 1);
+                        } else if (key == "stripe") {
+                                auto e = parseEntry(line);
+                                if (!e)
+                                        return makeBad<Manifest>(e.error());
+                                m.entries.push_back(e.extract());
+                        }
+                } catch (const std::exception&) {
+                        return makeBad<Manifest>("Bad manifest: " + line);
+                }
+        }
+        return m;
+}
+
+std::string Manifest::serialize() const
+{
+        std::ostringstream out;
+        out << MAGIC << "\n";
+        out << "source " << source << "\n";
+        out << "size " << size << "\n";
+        if (interleave) {
+                out << "interleave " << interleave << "\n";
+                out << "unit " << unit << "\n";
+        }
+        if (!compress.empty())
+                out << "compress " << compress << "\n";
+        if (headers)
+                out << "headers 1\n";
+        if (store)
+                out << "store 1\n";
+        if (indexOnly) {
+                out << "index-only 1\n";
+                out << "inode " << inode << "\n";
+        }
+        if (mtime)
+                out << "mtime " << mtime << "\n";
+        for (size_t i = 0; i < dirs.size(); i++)
+                out << "dir " << i << " " << dirs[i] << "\n";
+        for (const auto& e : entries) {
+                out << "stripe index=" << e.index
+                    << " offset=" << e.offset
+                    << " length=" << e.length;
+                if (e.stored)
+                        out << " stored=" << e.stored;
+                out << " dir=" << e.dir
+                    << " name=" << e.name << "\n";
+        }
+        return out.str();
+}
+
+/// written beside the target and renamed over it so readers never see a
+/// partial manifest, the temporary is named per host and process since
+/// several --shard participants may publish the same manifest at once
+Error Manifest::write(const std::string& path, const bool durable) const
+{
+        char host[HOST_NAME_MAX + 1] = {};
+        ::gethostname(host, HOST_NAME_MAX);
+        const auto tmp = path + "." + host + "." + std::to_string(::getpid())
+            + ".tmp";
+        const auto text = serialize();
+        {
+                auto file = FileDesc::openWrite(tmp);
+                if (!file)
+                        return file.error();
+                if (const auto e = file->writeAt(text.data(), text.size(), 0))
+                        return e;
+                if (durable)
+                        if (const auto e = file->sync())
+                                return e;
+                if (const auto e = file->close())
+                        return e;
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) == -1)
+                return util::sysError("Failed to rename", tmp);
+        return NONE;
+}
@@ -0,0 +1,74 @@
+/**
+ * File: Manifest.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef MANIFEST_HH
+#define MANIFEST_HH
+
+#include "src/Maybe.hh"
+#include "src/types.hh"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+struct ManifestEntry {
+        size_t index = 0;
+        off_t offset = 0; /// in the source
+        std::streamsize length = 0;
+        std::streamsize stored = 0; /// compressed size, 0 when not
+        size_t dir = 0;
+        std::string name;
+};
+
+/// Text record of a stripe set, one "key value" line per field and one
+/// line of key=value pairs per stripe. name= is always last on a stripe
+/// line and runs to the end of it.
+///
+/// zebra-manifest 1
+/// source /data/file.bin
+/// size 10000000
+/// dir 0 /mnt/a
+/// interleave 4   (interleaved sets only)
+/// unit 65536
+/// compress zstd:3 (compressed sets only, stripes then carry stored=)
+/// headers 1      (stripes start with a StripeHeader)
+/// store 1        (stripes are shared objects of a --store)
+/// index-only 1   (no stripe files, see --index-only)
+/// inode 1234     (identity of the source for index-only sets)
+/// mtime 1700000000123456789 (index-only sets and --shard records)
+/// stripe index=0 offset=0 length=3000000 dir=0 name=0.stripe
+struct Manifest {
+        std::string source;
+        std::streamsize size = 0;
+        size_t interleave = 0;
+        std::streamsize unit = 0;
+        std::string compress;
+        bool headers = false;
+        bool store = false;
+        bool indexOnly = false;
+        unsigned long long inode = 0;
+        long long mtime = 0; /// nanoseconds
+        std::vector<std::string> dirs;
+        std::vector<ManifestEntry> entries;
+        static std::string fileName(const std::string& name);
+        static std::string readyName(const std::string& name);
+        static std::string shardName(const std::string& name,
+            const size_t shard, const size_t shards);
+        static Maybe<Manifest> read(const std::string& path);
+        std::string serialize() const;
+        Error write(const std::string& path, const bool durable) const;
+};
+
+#endif /// MANIFEST_HH
@@ -19,9 +19,18 @@
 #include "src/UtilStripe.hh"
 #include "src/UtilAssemblerMulti.hh"
 #include "src/UtilStripeFixed.hh"
+#include "src/UtilStripeInterleave.hh"
+#include "src/UtilStripeLines.hh"
+#include "src/UtilStripeHash.hh"
+#include "src/UtilExtract.hh"
+#include "src/UtilMaterialize.hh"
+#include "src/UtilRestripe.hh"
 #include "src/utils.hh"
 #include "src/consts.hh"
-#include "types.hh"
+#include "src/types.hh"
+#include <filesystem>
+
+namespace fs = std::filesystem;
 
 Error Parser::runParse(const ArgList args)
 {
@@ -36,8 +45,9 @@ Error Parser::runParse(const ArgList args)
         } else if (isOpt(arg)) {
                 if (argMap_.find(arg) != argMap_.end())
                         return "Duplicate " + arg;
+                /// a lone "-" is a value, stdout
                 const auto acc = ty::takeWhile(args->next_, [](const auto& s) {
-                        return !(s.size() > 0 && s[0] == '-');
+                        return s == "-" || !(s.size() > 0 && s[0] == '-');
                 });
                 if (ty::any(acc, [](const auto& s) { return s.empty(); }))
                         return arg + " empty option";
@@ -60,9 +70,25 @@ Parser::Mode Parser::toMode(const std::string& mode) const
 {
         if (mode == "-A" || mode == "--Assemble") {
                 const auto& val = util::mapOr(argMap_, { "--input", "-i" });
-                return ty::count(val) > 1 ? Mode::ASM_MULTI : Mode::ASM;
+                const bool dirs = !ty::any(val, [](const auto& s) {
+                        return !fs::is_directory(s);
+                });
+                return ty::count(val) > 1 && !dirs ? Mode::ASM_MULTI
+                                                   : Mode::ASM;
         }
+        if (mode == "-E" || mode == "--Extract")
+                return Mode::EXTRACT;
+        if (mode == "-M" || mode == "--Materialize")
+                return Mode::MATERIALIZE;
+        if (mode == "-R" || mode == "--Restripe")
+                return Mode::RESTRIPE;
         if (mode == "-S" || mode == "--Stripe") {
+                if (util::contains(argMap_, { "--interleave", "-il" }))
+                        return Mode::STRIPE_INTERLEAVE;
+                if (util::contains(argMap_, { "--hash", "-hs" }))
+                        return Mode::STRIPE_HASH;
+                if (util::contains(argMap_, { "--lines", "-l" }))
+                        return Mode::STRIPE_LINES;
                 const auto& p = util::contains(argMap_, { "--parts", "-p" });
                 return p ? Mode::STRIPE_FIXED : Mode::STRIPE;
         }
@@ -120,10 +146,22 @@ UtilPtr Parser::createPtr(const Mode m) const
                 return std::make_unique<UtilStripe>();
         case Mode::STRIPE_FIXED :
                 return std::make_unique<UtilStripeFixed>();
+        case Mode::STRIPE_INTERLEAVE :
+                return std::make_unique<UtilStripeInterleave>();
+        case Mode::STRIPE_LINES :
+                return std::make_unique<UtilStripeLines>();
+        case Mode::STRIPE_HASH :
+                return std::make_unique<UtilStripeHash>();
         case Mode::ASM :
                 return std::make_unique<UtilAssembler>();
         case Mode::ASM_MULTI :
                 return std::make_unique<UtilAssemblerMulti>();
+        case Mode::EXTRACT :
+                return std::make_unique<UtilExtract>();
+        case Mode::MATERIALIZE :
+                return std::make_unique<UtilMaterialize>();
+        case Mode::RESTRIPE :
+                return std::make_unique<UtilRestripe>();
         default :
                 return nullptr;
         }
@@ -26,7 +26,10 @@ using UtilPtr = std::unique_ptr<UtilBase>;
 
 class Parser {
 private:
-        enum class Mode { NONE, STRIPE, STRIPE_FIXED, ASM, ASM_MULTI, };
+        enum class Mode {
+            NONE, STRIPE, STRIPE_FIXED, STRIPE_INTERLEAVE, STRIPE_LINES,
+            STRIPE_HASH, ASM, ASM_MULTI, EXTRACT, MATERIALIZE, RESTRIPE,
+        };
         std::string mode_;
         ArgMap argMap_;
         bool isUpper(const char c) const;
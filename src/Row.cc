@@ -16,6 +16,7 @@
 
 #include "src/Row.hh"
 #include <iostream>
+#include <iomanip>
 
 void Row::print(const Dir& d, const std::string& path,
     const std::streamsize& bytes)
@@ -24,3 +25,9 @@ void Row::print(const Dir& d, const std::string& path,
         if (it != arrows_.end())
                 std::cout << it->second << path << " " << bytes << " bytes\n";
 }
+
+void Row::timing(const std::string& what, const double ms)
+{
+        std::cout << "\033[33m~~\033[0m" << what << " " << std::fixed
+            << std::setprecision(1) << ms << " ms\n";
+}
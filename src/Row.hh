@@ -21,13 +21,14 @@
 #include <unordered_map>
 #include <string>
 
-enum Dir { LEFT, RIGHT };
+enum Dir { LEFT, RIGHT, SAME };
 
 class Row {
 private:
         inline static const std::unordered_map<Dir, std::string> arrows_ = {
             { LEFT, "\033[32m<-\033[0m" },
             { RIGHT, "\033[32m->\033[0m" },
+            { SAME, "\033[36m==\033[0m" }, /// already stored
         };
 public:
         Row() = default;
@@ -35,6 +36,7 @@ public:
         Row(const Row&) = delete;
         static void print(const Dir& d, const std::string& path,
             const std::streamsize& bytes);
+        static void timing(const std::string& what, const double ms);
 };
 
 #endif /// ROW_HH
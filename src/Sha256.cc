@@ -0,0 +1,141 @@
+/**
+ * File: Sha256.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Sha256.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr std::uint32_t rotr(const std::uint32_t x, const int n)
+{
+        return (x >> n) | (x << (32 - n));
+}
+
+} /// namespace
+
+Sha256::Sha256()
+    : state_{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 }
+    , block_{}
+{ }
+
+void Sha256::compress(const unsigned char* p)
+{
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+                w[i] = std::uint32_t(p[4 * i]) << 24
+                    | std::uint32_t(p[4 * i + 1]) << 16
+                    | std::uint32_t(p[4 * i + 2]) << 8
+                    | std::uint32_t(p[4 * i + 3]);
+        for (int i = 16; i < 64; i++) {
+                const auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18)
+                    ^ (w[i - 15] >> 3);
+                const auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19)
+                    ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        auto [a, b, c, d, e, f, g, h] = state_;
+        for (int i = 0; i < 64; i++) {
+                const auto s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                const auto ch = (e & f) ^ (~e & g);
+                const auto t1 = h + s1 + ch + K[i] + w[i];
+                const auto s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                const auto maj = (a & b) ^ (a & c) ^ (b & c);
+                const auto t2 = s0 + maj;
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+        }
+        state_[0] += a;
+        state_[1] += b;
+        state_[2] += c;
+        state_[3] += d;
+        state_[4] += e;
+        state_[5] += f;
+        state_[6] += g;
+        state_[7] += h;
+}
+
+void Sha256::update(const char* p, size_t n)
+{
+        const auto* u = reinterpret_cast<const unsigned char*>(p);
+        bytes_ += n;
+        if (used_) {
+                const auto take = std::min(n, block_.size() - used_);
+                std::memcpy(block_.data() + used_, u, take);
+                used_ += take;
+                u += take;
+                n -= take;
+                if (used_ < block_.size())
+                        return;
+                compress(block_.data());
+                used_ = 0;
+        }
+        for (; n >= 64; u += 64, n -= 64)
+                compress(u);
+        std::memcpy(block_.data(), u, n);
+        used_ = n;
+}
+
+std::array<unsigned char, 32> Sha256::digest()
+{
+        const std::uint64_t bits = bytes_ * 8;
+        const char one = static_cast<char>(0x80);
+        update(&one, 1);
+        const char zero = 0;
+        while (used_ != 56)
+                update(&zero, 1);
+        char length[8];
+        for (int i = 0; i < 8; i++)
+                length[i] = static_cast<char>(bits >> (56 - 8 * i));
+        update(length, 8);
+        std::array<unsigned char, 32> out;
+        for (int i = 0; i < 8; i++)
+                for (int j = 0; j < 4; j++)
+                        out[4 * i + j] = state_[i] >> (24 - 8 * j);
+        return out;
+}
+
+std::string Sha256::hex()
+{
+        static const char digits[] = "0123456789abcdef";
+        std::string out;
+        for (const auto byte : digest()) {
+                out.push_back(digits[byte >> 4]);
+                out.push_back(digits[byte & 0xf]);
+        }
+        return out;
+}
@@ -0,0 +1,40 @@
+/**
+ * File: Sha256.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SHA256_HH
+#define SHA256_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// FIPS 180-4 SHA-256, fed incrementally.
+class Sha256 {
+private:
+        std::array<std::uint32_t, 8> state_;
+        std::array<unsigned char, 64> block_;
+        size_t used_ = 0;
+        std::uint64_t bytes_ = 0;
+        void compress(const unsigned char* p);
+public:
+        Sha256();
+        void update(const char* p, size_t n);
+        std::array<unsigned char, 32> digest();
+        std::string hex();
+};
+
+#endif /// SHA256_HH
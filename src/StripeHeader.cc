@@ -0,0 +1,88 @@
+/**
+ * File: StripeHeader.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/StripeHeader.hh"
+#include "src/Crc32.hh"
+#include "src/utils.hh"
+#include <cstring>
+#include <random>
+
+namespace {
+
+constexpr char MAGIC[8] = { 'Z', 'E', 'B', 'R', 'A', 'H', 'D', '1' };
+
+} /// namespace
+
+StripeHeader::SetId StripeHeader::newSet()
+{
+        std::random_device rd;
+        SetId id;
+        for (auto& b : id)
+                b = static_cast<unsigned char>(rd());
+        return id;
+}
+
+std::string StripeHeader::setHex() const
+{
+        return hex(set);
+}
+
+std::string StripeHeader::hex(const SetId& set)
+{
+        constexpr char digits[] = "0123456789abcdef";
+        std::string hex;
+        for (const auto b : set) {
+                hex += digits[b >> 4];
+                hex += digits[b & 0xf];
+        }
+        return hex;
+}
+
+std::array<char, StripeHeader::SIZE> StripeHeader::encode() const
+{
+        std::array<char, SIZE> h{};
+        std::memcpy(h.data(), MAGIC, sizeof(MAGIC));
+        std::memcpy(h.data() + 8, set.data(), set.size());
+        util::putLE(h.data() + 24, index, 8);
+        util::putLE(h.data() + 32, count, 8);
+        util::putLE(h.data() + 40, offset, 8);
+        util::putLE(h.data() + 48, length, 8);
+        util::putLE(h.data() + 56, crc, 4);
+        util::putLE(h.data() + 60, crc32::update(0, h.data(), 60), 4);
+        return h;
+}
+
+Maybe<std::optional<StripeHeader>> StripeHeader::read(const FileDesc& file)
+{
+        using Header = std::optional<StripeHeader>;
+        std::array<char, SIZE> h;
+        const auto r = file.readAt(h.data(), SIZE, 0);
+        if (!r)
+                return makeBad<Header>(r.error());
+        if (*r != SIZE || std::memcmp(h.data(), MAGIC, sizeof(MAGIC)))
+                return Header();
+        if (util::getLE(h.data() + 60, 4) != crc32::update(0, h.data(), 60))
+                return makeBad<Header>("Corrupt stripe header: "
+                    + file.path());
+        StripeHeader s;
+        std::memcpy(s.set.data(), h.data() + 8, s.set.size());
+        s.index = util::getLE(h.data() + 24, 8);
+        s.count = util::getLE(h.data() + 32, 8);
+        s.offset = util::getLE(h.data() + 40, 8);
+        s.length = util::getLE(h.data() + 48, 8);
+        s.crc = util::getLE(h.data() + 56, 4);
+        return Header(s);
+}
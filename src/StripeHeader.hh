@@ -0,0 +1,54 @@
+/**
+ * File: StripeHeader.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef STRIPE_HEADER_HH
+#define STRIPE_HEADER_HH
+
+#include "src/Maybe.hh"
+#include "src/FileDesc.hh"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/// Fixed size header in front of a --header stripe, little endian:
+///
+/// 0   magic "ZEBRAHD1"
+/// 8   set id, 16 random bytes shared by every stripe of a run
+/// 24  index
+/// 32  count
+/// 40  offset in the source
+/// 48  length of the data after the header
+/// 56  CRC-32 of that data
+/// 60  CRC-32 of bytes 0 to 60
+struct StripeHeader {
+        static constexpr size_t SIZE = 64;
+        using SetId = std::array<unsigned char, 16>;
+        SetId set{};
+        std::uint64_t index = 0;
+        std::uint64_t count = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        std::uint32_t crc = 0;
+        static SetId newSet();
+        std::string setHex() const;
+        static std::string hex(const SetId& set);
+        std::array<char, SIZE> encode() const;
+        /// nothing when the file does not start with a header
+        static Maybe<std::optional<StripeHeader>> read(const FileDesc& file);
+};
+
+#endif /// STRIPE_HEADER_HH
@@ -18,22 +18,524 @@
 #include "src/Maybe.hh"
 #include "src/types.hh"
 #include "src/utils.hh"
-#include "src/consts.hh"
+#include "src/BufferPool.hh"
+#include "src/Durability.hh"
 #include "src/Row.hh"
+#include "src/Watcher.hh"
+#include "src/StripeHeader.hh"
+#include "src/Bundle.hh"
+#include "src/consts.hh"
 #include <iostream>
+#include <algorithm>
+#include <sys/inotify.h>
 
+/// matching files of every input directory ordered by file name, so stripes
+/// spread over several directories interleave back into place
 Maybe<FilesL> UtilAssembler::stripeNames() const
 {
+        std::vector<std::pair<std::string, std::string>> found;
+        for (const auto& in : ins_) {
+                if (!fs::exists(in) || !fs::is_directory(in))
+                        return makeBad<FilesL>("Not a directory: " + in);
+                for (const auto& file : fs::directory_iterator(in)) {
+                        if (matchExt(file) && matchName(file)) {
+                                const auto name = file.path().filename();
+                                const auto p = fs::path(in) / name;
+                                found.emplace_back(name.string(), p.string());
+                        }
+                }
+        }
+        std::sort(found.begin(), found.end());
         FilesL files = ty::Null<std::string>;
-        if (!fs::exists(in_) || !fs::is_directory(in_))
-                return makeBad<FilesL>("Not a directory: " + in_);
-        for (const auto& file : fs::directory_iterator(in_)) {
-                if (matchExt(file) && matchName(file)) {
-                        const auto p = fs::path(in_) / file.path().filename();
-                        files = ty::push(p.string(), files);
+        for (auto it = found.rbegin(); it != found.rend(); it++)
+                files = ty::push(it->second, files);
+        return files;
+}
+
+Maybe<std::string> UtilAssembler::findStripe(const Manifest& m,
+    const ManifestEntry& e) const
+{
+        for (const auto& in : ins_)
+                if (const auto p = fs::path(in) / e.name; fs::exists(p))
+                        return p.string();
+        if (e.dir < m.dirs.size())
+                if (const auto p = fs::path(m.dirs[e.dir]) / e.name;
+                    fs::exists(p))
+                        return p.string();
+        return makeBad<std::string>("Missing stripe: " + e.name);
+}
+
+/// a manifest in any input directory records where every stripe was placed
+/// and its offset, otherwise stripes are discovered by name
+std::string UtilAssembler::manifestPath() const
+{
+        for (const auto& in : ins_)
+                if (const auto p = fs::path(in) / Manifest::fileName(name_);
+                    fs::exists(p))
+                        return p.string();
+        return "";
+}
+
+Maybe<Parts> UtilAssembler::discovered() const
+{
+        const auto files = stripeNames();
+        if (!files)
+                return makeBad<Parts>(files.error());
+        return layout(*files);
+}
+
+Maybe<Parts> UtilAssembler::fromManifest(const Manifest& m) const
+{
+        Parts parts;
+        for (const auto& e : m.entries) {
+                const auto p = findStripe(m, e);
+                if (!p)
+                        return makeBad<Parts>(p.error());
+                std::error_code ec;
+                const auto size = fs::file_size(*p, ec);
+                const off_t skip = m.headers ? StripeHeader::SIZE : 0;
+                const auto want = skip
+                    + (m.compress.empty() ? e.length : e.stored);
+                if (ec || static_cast<std::streamsize>(size) != want)
+                        return makeBad<Parts>("Stripe size mismatch: " + *p);
+                parts.push_back({ *p, skip, e.offset, e.length, e.stored });
+        }
+        return parts;
+}
+
+Error UtilAssembler::setSet(const ArgMap& map)
+{
+        if (const auto e = setMember(map, SET_A, set_))
+                return *e;
+        std::transform(set_.begin(), set_.end(), set_.begin(), [](char c) {
+                return static_cast<char>(std::tolower(
+                    static_cast<unsigned char>(c)));
+        });
+        const bool hex = std::all_of(set_.begin(), set_.end(), [](char c) {
+                return util::isDigit(c) || (c >= 'a' && c <= 'f');
+        });
+        if (!set_.empty() && (set_.size() != 32 || !hex))
+                return "Bad set " + set_ + ", expected 32 hex digits";
+        return NONE;
+}
+
+/// the set named by --set, otherwise the only one found
+Maybe<std::string> UtilAssembler::chosen(const std::vector<std::string>& sets)
+    const
+{
+        if (!set_.empty()) {
+                if (std::find(sets.begin(), sets.end(), set_) == sets.end())
+                        return makeBad<std::string>("No stripes of set "
+                            + set_);
+                return set_;
+        }
+        std::vector<std::string> unique(sets);
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()),
+            unique.end());
+        if (unique.size() > 1) {
+                std::string all;
+                for (const auto& s : unique)
+                        all += (all.empty() ? "" : ", ") + s;
+                return makeBad<std::string>("Stripes of several sets: " + all
+                    + "\nPick one with --set");
+        }
+        return unique.front();
+}
+
+/// --header: any file in the inputs starting with a stripe header is placed
+/// by that header alone, so names and order do not matter. Stripes of the
+/// set --set names, or of the only set found, have to cover it, files of
+/// other sets are skipped with a warning.
+Maybe<Parts> UtilAssembler::headed() const
+{
+        std::vector<std::pair<StripeHeader, std::string>> found;
+        for (const auto& in : ins_) {
+                std::error_code ec;
+                std::vector<std::string> files;
+                if (fs::is_regular_file(in))
+                        files.push_back(in);
+                for (const auto& entry : fs::directory_iterator(in, ec))
+                        if (entry.is_regular_file())
+                                files.push_back(entry.path().string());
+                for (const auto& f : files) {
+                        const auto file = FileDesc::openRead(f);
+                        if (!file)
+                                return makeBad<Parts>(file.error());
+                        auto h = StripeHeader::read(*file);
+                        if (!h)
+                                return makeBad<Parts>(h.error());
+                        if (*h)
+                                found.push_back({ **h, f });
                 }
         }
-        return ty::sort(files);
+        if (found.empty())
+                return makeBad<Parts>("No stripe headers found");
+        /// directory order is arbitrary, reports should not be
+        std::sort(found.begin(), found.end(), [](const auto& a,
+            const auto& b) {
+                return a.second < b.second;
+        });
+        std::vector<std::string> sets;
+        for (const auto& [h, path] : found)
+                sets.push_back(h.setHex());
+        const auto set = chosen(sets);
+        if (!set)
+                return makeBad<Parts>(set.error());
+        const auto foreign = std::remove_if(found.begin(), found.end(),
+            [&](const auto& f) {
+                if (f.first.setHex() == *set)
+                        return false;
+                std::cerr << "Skipping " << f.second << ", stripe of set "
+                    << f.first.setHex() << "\n";
+                return true;
+        });
+        found.erase(foreign, found.end());
+        const auto& first = found.front().first;
+        /// a corrupt count must not size the table
+        if (first.count > found.size())
+                return makeBad<Parts>("Missing stripes, " + std::to_string(
+                    found.size()) + " of " + std::to_string(first.count)
+                    + " in set " + first.setHex());
+        std::vector<const std::string*> slots(first.count);
+        Parts parts;
+        for (const auto& [h, path] : found) {
+                if (h.count != first.count || h.index >= h.count)
+                        return makeBad<Parts>("Bad stripe header: " + path);
+                if (slots[h.index])
+                        return makeBad<Parts>("Stripe " + std::to_string(
+                            h.index) + " twice: " + *slots[h.index] + " and "
+                            + path);
+                slots[h.index] = &path;
+                std::error_code ec;
+                const auto size = fs::file_size(path, ec);
+                if (ec || size != StripeHeader::SIZE + h.length)
+                        return makeBad<Parts>("Stripe size mismatch: " + path);
+                parts.push_back({ path, StripeHeader::SIZE,
+                    static_cast<off_t>(h.offset),
+                    static_cast<std::streamsize>(h.length), 0, h.crc });
+        }
+        for (size_t i = 0; i < slots.size(); i++)
+                if (!slots[i])
+                        return makeBad<Parts>("Missing stripe "
+                            + std::to_string(i) + " of set " + first.setHex());
+        return parts;
+}
+
+/// a set without a manifest is headed when its first stripe starts with a
+/// header, so it is never read as raw data without --header
+Maybe<bool> UtilAssembler::sniffed() const
+{
+        const auto files = stripeNames();
+        if (!files)
+                return makeBad<bool>(files.error());
+        if (!*files)
+                return false;
+        const auto file = FileDesc::openRead((*files)->val_);
+        if (!file)
+                return makeBad<bool>(file.error());
+        const auto h = StripeHeader::read(*file);
+        if (!h)
+                return makeBad<bool>(h.error());
+        return h->has_value();
+}
+
+std::vector<std::string> UtilAssembler::bundlePaths() const
+{
+        std::vector<std::string> paths;
+        for (const auto& in : ins_)
+                if (const auto p = fs::path(in) / Bundle::fileName(name_);
+                    fs::exists(p))
+                        paths.push_back(p.string());
+        return paths;
+}
+
+/// Every stripe comes from a bundle index, each bundle is opened once and
+/// that descriptor serves all of its stripes.
+Maybe<Parts> UtilAssembler::bundled(const std::vector<std::string>& paths)
+    const
+{
+        std::vector<std::pair<Bundle, std::string>> found;
+        std::vector<std::shared_ptr<const FileDesc>> files;
+        std::vector<std::string> sets;
+        for (const auto& path : paths) {
+                auto opened = FileDesc::openRead(path);
+                if (!opened)
+                        return makeBad<Parts>(opened.error());
+                files.push_back(std::make_shared<const FileDesc>(
+                    opened.extract()));
+                auto b = Bundle::read(*files.back());
+                if (!b)
+                        return makeBad<Parts>(b.error());
+                sets.push_back(StripeHeader::hex(b->set));
+                found.push_back({ b.extract(), path });
+        }
+        const auto set = chosen(sets);
+        if (!set)
+                return makeBad<Parts>(set.error());
+        Parts parts;
+        std::optional<Bundle> first;
+        std::vector<bool> seen;
+        for (size_t i = 0; i < found.size(); i++) {
+                const auto& [b, path] = found[i];
+                const auto& file = files[i];
+                if (sets[i] != *set) {
+                        std::cerr << "Skipping " << path << ", bundle of set "
+                            << sets[i] << "\n";
+                        continue;
+                }
+                if (!first) {
+                        first = b;
+                        seen.assign(b.count, false);
+                } else if (b.count != first->count) {
+                        return makeBad<Parts>("Bad bundle index: " + path);
+                }
+                for (const auto& e : b.entries) {
+                        if (e.index >= seen.size() || seen[e.index])
+                                return makeBad<Parts>("Bad bundle index: "
+                                    + path);
+                        seen[e.index] = true;
+                        parts.push_back({ path, static_cast<off_t>(e.at),
+                            static_cast<off_t>(e.offset),
+                            static_cast<std::streamsize>(e.length), 0, e.crc,
+                            file });
+                }
+        }
+        for (size_t i = 0; i < seen.size(); i++)
+                if (!seen[i])
+                        return makeBad<Parts>("Missing stripe "
+                            + std::to_string(i) + ", not in any bundle");
+        return parts;
+}
+
+/// stripes of a compressed set are expanded while copied
+Error UtilAssembler::useCodec(const Manifest& m)
+{
+        if (m.compress.empty())
+                return NONE;
+        const auto c = Compression::parse(m.compress);
+        if (!c)
+                return c.error();
+        if (const auto codec = Codec::create(*c); !codec)
+                return codec.error();
+        compression_ = *c;
+        return NONE;
+}
+
+Error UtilAssembler::interleaved(const Manifest& m)
+{
+        constexpr size_t maxWindow = 1'024 * 1'024 * 64;
+        auto entries = m.entries;
+        std::sort(entries.begin(), entries.end(), [](const auto& a,
+            const auto& b) {
+                return a.index < b.index;
+        });
+        FilesL files = ty::Null<std::string>;
+        for (auto it = entries.rbegin(); it != entries.rend(); it++) {
+                const auto p = findStripe(m, *it);
+                if (!p)
+                        return p.error();
+                files = ty::push(*p, files);
+        }
+        const size_t unit = m.unit;
+        io_.bufferSize = std::max({ io_.bufferSize, unit,
+            std::min(maxWindow, m.interleave * unit) });
+        BufferPool::instance().configure(io_);
+        const Interleave layout(m.interleave, m.unit, m.size);
+        return assemble(layout, files, out_, silence_, io_, threadc_);
+}
+
+/// the number a stripe name ends in, none when it has no or too many digits
+std::optional<size_t> UtilAssembler::number(const std::string& name) const
+{
+        const auto stem = fs::path(name).stem().string();
+        const auto digits = stem.substr(stemToName(stem).size());
+        if (digits.empty() || digits.size() >= 10)
+                return std::nullopt;
+        return std::stoull(digits);
+}
+
+/// total output size once it is known, -1 before
+std::streamsize UtilAssembler::expected() const
+{
+        if (laidOut_)
+                return layout_.size;
+        const auto last = arrivals_.end();
+        for (auto it = arrivals_.begin(); it != last; it++) {
+                if (count_ && it->second.closed
+                    && number(it->first) == count_ - 1) {
+                        std::error_code ec;
+                        const auto size = fs::file_size(it->second.path, ec);
+                        if (!ec)
+                                return (count_ - 1) * unit_ + size;
+                }
+        }
+        return -1;
+}
+
+/// Where a closed stripe goes in the output. Nothing yet while the layout
+/// is unknown or the file does not have the size the layout expects.
+Maybe<std::optional<Part>> UtilAssembler::locate(const std::string& name,
+    const Arrival& a)
+{
+        using Place = std::optional<Part>;
+        std::error_code ec;
+        const std::streamsize size = fs::file_size(a.path, ec);
+        if (ec)
+                return Place();
+        if (laidOut_) {
+                const bool packed = !layout_.compress.empty();
+                for (const auto& e : layout_.entries)
+                        if (e.name == name)
+                                return (packed ? e.stored : e.length) == size
+                                    ? Place(Part{ a.path, 0, e.offset,
+                                        e.length, e.stored })
+                                    : Place();
+                return Place();
+        }
+        if (!count_)
+                return Place();
+        const auto n = number(name);
+        if (!n)
+                return makeBad<Place>("No stripe number: " + name);
+        const size_t index = *n;
+        if (index >= count_)
+                return makeBad<Place>("Stripe beyond --count: " + name);
+        const bool last = index + 1 == count_;
+        if (count_ > 1 && size > unit_)
+                return makeBad<Place>("Stripe larger than --size: " + a.path);
+        /// closed before it was complete, it closes again later
+        if (!last && size < unit_)
+                return Place();
+        return Place(Part{ a.path, 0, static_cast<off_t>(index * unit_),
+            size });
+}
+
+/// A stripe closed after writing or moved in. A manifest, the full one or
+/// the .ready prefix of an --ordered run, gives the layout and the stripes
+/// a .ready lists are complete.
+Error UtilAssembler::arrive(const std::string& path)
+{
+        const fs::directory_entry file(path);
+        const auto name = file.path().filename().string();
+        const bool ready = name == Manifest::readyName(name_);
+        if (name == Manifest::fileName(name_) || ready) {
+                if (count_)
+                        return NONE;
+                const auto m = Manifest::read(path);
+                if (!m)
+                        return m.error();
+                if (m->interleave)
+                        return "Cannot watch an interleaved set";
+                if (m->indexOnly)
+                        return "Index only set, use --Materialize";
+                if (const auto e = useCodec(*m))
+                        return *e;
+                if (!ready || !laidOut_ || layout_.entries.size()
+                    < m->entries.size())
+                        layout_ = *m;
+                laidOut_ = true;
+                if (ready && !ordered_) {
+                        /// anything copied on a close event may be partial
+                        arrivals_.clear();
+                        copied_ = 0;
+                        ordered_ = true;
+                }
+                for (const auto& e : ready ? m->entries
+                    : std::vector<ManifestEntry>()) {
+                        auto& a = arrivals_[e.name];
+                        if (const auto p = findStripe(*m, e); p && !a.copied) {
+                                a.path = *p;
+                                a.closed = true;
+                        }
+                }
+                return NONE;
+        }
+        /// stripes of an --ordered run close once per piece
+        if (ordered_ || !matchExt(file) || !matchName(file))
+                return NONE;
+        /// closed again, the new contents are copied over the old
+        auto& a = arrivals_[name];
+        copied_ -= a.length;
+        a = { path, true, false, 0 };
+        return NONE;
+}
+
+/// Assembles while stripes are still arriving. Files already in the input
+/// directories are taken as complete, later ones once inotify reports them
+/// closed or moved in. Every stripe is written at its own offset, so the
+/// order they come in does not matter.
+Error UtilAssembler::watch()
+{
+        auto watcher = Watcher::open();
+        if (!watcher)
+                return watcher.error();
+        for (const auto& in : ins_)
+                if (const auto e = watcher->add(in,
+                    IN_CLOSE_WRITE | IN_MOVED_TO))
+                        return *e;
+        const auto manifest = manifestPath();
+        if (!manifest.empty())
+                if (const auto e = arrive(manifest))
+                        return *e;
+        for (const auto& in : ins_)
+                if (const auto p = fs::path(in) / Manifest::readyName(name_);
+                    fs::exists(p))
+                        if (const auto e = arrive(p.string()))
+                                return *e;
+        const auto files = stripeNames();
+        if (!files)
+                return files.error();
+        for (auto f = *files; f; f = f->next_)
+                if (const auto e = arrive(f->val_))
+                        return *e;
+        auto output = FileDesc::openWrite(out_);
+        if (!output)
+                return output.error();
+        IOBuffer buffer;
+        bool reserved = false;
+        while (expected() < 0 || copied_ < expected()) {
+                for (auto& [name, a] : arrivals_) {
+                        if (!a.closed || a.copied)
+                                continue;
+                        const auto part = locate(name, a);
+                        if (!part)
+                                return part.error();
+                        if (!*part)
+                                continue;
+                        if (!copy(**part, *output, buffer, silence_, io_))
+                                return fmsg_;
+                        a.copied = true;
+                        a.length = (*part)->length;
+                        copied_ += a.length;
+                }
+                const auto total = expected();
+                if (total >= 0 && !reserved) {
+                        if (const auto e = reserve(total, out_))
+                                return *e;
+                        if (const auto e = output->allocate(total, io_.sparse))
+                                return *e;
+                        reserved = true;
+                }
+                if (total >= 0 && copied_ >= total)
+                        break;
+                const auto events = watcher->next(-1);
+                if (!events)
+                        return events.error();
+                for (const auto& ev : *events)
+                        if (const auto e = arrive(ev.path))
+                                return *e;
+        }
+        if (!silence_)
+                Row::print(RIGHT, out_, copied_);
+        Durability dur(io_.sync);
+        if (const auto e = dur.settle(output.extract()))
+                return *e;
+        if (const auto e = dur.finish({ fs::path(out_).parent_path() }))
+                return *e;
+        if (!silence_ && io_.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
 }
 
 Conflict UtilAssembler::conflicting() const
@@ -76,37 +578,116 @@ std::string UtilAssembler::stemToName(const std::string& stem) const
 
 Error UtilAssembler::setArgs(const ArgMap& map)
 {
-        if (const auto e = UtilBaseSingle::setArgs(map))
+        if (const auto e = setPaths(map, IN_A, ins_))
+                return *e;
+        in_ = ins_.front();
+        if (const auto e = setPath(map, OUT_A, out_))
+                return *e;
+        if (const auto e = setIOArgs(map))
                 return *e;
         if (const auto e = setMember(map, EXT_A, ext_))
                 return *e;
         if (const auto e = setMember(map, NAME_A, name_))
                 return *e;
+        threadc_ = ins_.size();
+        if (const auto e = setThreads(map, threadc_))
+                return *e;
+        std::string count;
+        if (const auto e = setMember(map, COUNT_A, count))
+                return *e;
+        if (count.size() >= 10
+            || !std::all_of(count.begin(), count.end(), util::isDigit))
+                return "Bad count " + count;
+        if (!count.empty())
+                count_ = std::stoull(count);
+        /// offsets follow from the stripe size, which a stripe closed before
+        /// it is complete would get wrong
+        if (count_) {
+                size_t unit = 0;
+                if (const auto e = setBytes(map, SIZE_A, unit))
+                        return *e;
+                if (count_ > 1 && !unit)
+                        return "Count needs the stripe --size";
+                unit_ = unit;
+        }
+        if (const auto e = setShard(map, shard_, shards_))
+                return *e;
+        if (const auto e = setSet(map))
+                return *e;
+        return NONE;
+}
+
+/// --in-place consumes its stripes, so every one has to belong to this set
+/// alone: found in an input directory and not an object of a store that
+/// other recipes point into
+Error UtilAssembler::owned(const Manifest& m, const Parts& parts) const
+{
+        if (m.store)
+                return "In place would remove objects of a store";
+        for (const auto& p : parts) {
+                const auto dir = fs::path(p.path).parent_path();
+                const bool input = std::any_of(ins_.begin(), ins_.end(),
+                    [&](const std::string& in) {
+                        std::error_code ec;
+                        return fs::equivalent(dir, in, ec);
+                });
+                if (!input)
+                        return "In place only consumes stripes in the input"
+                            " directories: " + p.path;
+        }
         return NONE;
 }
 
 Error UtilAssembler::run()
 {
+        silence_ = silence_ || out_ == STDOUT_PATH;
         if (!silence_)
                 std::cout << util::BANNER << "\nAssembling\n";
-        const auto stripes = stripeNames();
-        if (!stripes)
-                return stripes.error();
-        if (!*stripes)
+        BufferPool::instance().configure(io_);
+        if (watch_)
+                return watch();
+        const auto path = manifestPath();
+        const auto m = path.empty() ? Maybe<Manifest>(Manifest())
+                                    : Manifest::read(path);
+        if (!m)
+                return m.error();
+        if (m->indexOnly)
+                return "Index only set, use --Materialize";
+        if (m->interleave && inPlace_)
+                return "In place needs plain stripes laid end to end";
+        if (m->interleave && shards_)
+                return "Shard assembles stripes laid end to end, use -E";
+        if (m->interleave)
+                return interleaved(*m);
+        if (const auto e = useCodec(*m))
+                return *e;
+        const auto bundles = bundlePaths();
+        const auto headers = path.empty() && bundles.empty() && !header_
+            ? sniffed() : Maybe<bool>(false);
+        if (!headers)
+                return headers.error();
+        const auto parts = !bundles.empty() ? bundled(bundles)
+            : header_ || m->headers || *headers ? headed()
+            : path.empty() ? discovered() : fromManifest(*m);
+        if (!parts)
+                return parts.error();
+        if (parts->empty())
                 return "No Pieces";
-        std::ofstream outFile(out_);
-        if (!outFile)
-                return "Failed to open: " + out_;
-        const auto bytes = writeStripe(*stripes, outFile, silence_);
-        if (!bytes)
-                return bytes.error();
-        if (!silence_)
-                Row::print(RIGHT, out_, *bytes);
-        return NONE;
+        if (inPlace_) {
+                if (const auto e = owned(*m, *parts))
+                        return *e;
+                return inPlace(*parts, out_, silence_, io_);
+        }
+        if (shards_)
+                return share(*parts, out_, shard_, shards_, silence_, io_,
+                    threadc_);
+        return assemble(*parts, out_, silence_, io_, threadc_);
 }
 
 Error UtilAssembler::setFlags(const ArgMap& map)
 {
+        if (const auto e = setIOFlags(map))
+                return *e;
         if (const auto m = validFlag(map, QUIET_F); m && *m)
                 silence_ = true;
         else if (!m)
@@ -119,18 +700,55 @@ Error UtilAssembler::setFlags(const ArgMap& map)
                 empty_ = true;
         else if (!m)
                 return m.error();
+        if (const auto m = validFlag(map, WATCH_F); m && *m)
+                watch_ = true;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, HEADER_F); m && *m)
+                header_ = true;
+        else if (!m)
+                return m.error();
+        if (watch_ && header_)
+                return "Watch does not read stripe headers";
+        if (watch_ && out_ == STDOUT_PATH)
+                return "Watch writes to a file";
+        if (const auto m = validFlag(map, IN_PLACE_F); m && *m)
+                inPlace_ = true;
+        else if (!m)
+                return m.error();
+        if (inPlace_ && (watch_ || out_ == STDOUT_PATH))
+                return "In place only assembles a finished set to a file";
+        /// a sparse write skips zeros, which only works on a fresh output
+        if (shards_ && (watch_ || inPlace_ || out_ == STDOUT_PATH
+            || io_.sparse))
+                return "Shard only assembles a finished set into a file";
         return NONE;
 }
 
 std::unordered_set<std::string> UtilAssembler::validArgs() const
 {
         return {
-            "--input"       , "-i" ,
-            "--output"      , "-o" ,
-            "--extension"   , "-e" ,
-            "--name"        , "-n" ,
-            "--quiet"       , "-q" ,
-            "--no-extension", "-ne",
-            "--no-name"     , "-nn",
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--threads"        , "-t" ,
+            "--extension"      , "-e" ,
+            "--name"           , "-n" ,
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--no-name"        , "-nn",
+            "--watch"          , "-w" ,
+            "--count"          , "-c" ,
+            "--size"           , "-s" ,
+            "--header"         , "-hd",
+            "--set"            , "-ss",
+            "--in-place"       , "-ip",
+            "--shard"          , "-sh",
+            "--streaming-cache", "-sc",
+            "--cache-window"   , "-cw",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sparse"         , "-sp",
+            "--sync"           , "-sy",
         };
 }
@@ -20,26 +20,73 @@
 #include "src/UtilBaseSingle.hh"
 #include "src/AssemblerIO.hh"
 #include "src/Maybe.hh"
+#include "src/Manifest.hh"
 #include <filesystem>
+#include <map>
+#include <optional>
 
 namespace fs = std::filesystem;
 
-class UtilAssembler final : public UtilBaseSingle
-                          , public AssemblerIO {
-private:
+class UtilAssembler : public UtilBaseSingle
+                    , public AssemblerIO {
+protected:
         std::string ext_ = "stripe";
         bool useExt_ = true;
         bool empty_ = false;
         std::string name_ = "";
+        std::vector<std::string> ins_;
+        int threadc_ = 1;
+        bool header_ = false;
+        std::string set_; /// --set, hex id of the headed or bundled set
         std::string stemToName(const std::string& stem) const;
         Maybe<FilesL> stripeNames() const;
-        std::unordered_set<std::string> validArgs() const override;
+        Maybe<std::string> findStripe(const Manifest& m,
+            const ManifestEntry& e) const;
+        std::string manifestPath() const;
+        Maybe<Parts> discovered() const;
+        Maybe<Parts> fromManifest(const Manifest& m) const;
+        Error setSet(const ArgMap& map);
+        Maybe<std::string> chosen(const std::vector<std::string>& sets)
+            const;
+        Maybe<Parts> headed() const;
+        Maybe<bool> sniffed() const;
+        std::vector<std::string> bundlePaths() const;
+        Maybe<Parts> bundled(const std::vector<std::string>& paths) const;
+        Error useCodec(const Manifest& m);
+        Error owned(const Manifest& m, const Parts& parts) const;
         bool matchExt(const fs::directory_entry& file) const;
         bool matchName(const fs::directory_entry& file) const;
         Conflict conflicting() const override;
+private:
+        /// --watch state, every stripe seen so far by file name
+        struct Arrival {
+                std::string path;
+                bool closed = false;
+                bool copied = false;
+                std::streamsize length = 0; /// copied so far
+        };
+        bool inPlace_ = false;
+        size_t shard_ = 0; /// --shard k/N, this run writes parts i % N == k
+        size_t shards_ = 0; /// 0 when not sharded
+        bool watch_ = false;
+        size_t count_ = 0;
+        std::map<std::string, Arrival> arrivals_;
+        Manifest layout_;
+        bool laidOut_ = false;
+        bool ordered_ = false; /// a .ready is the only sign of completion
+        std::streamsize unit_ = 0; /// --size of a full stripe with --count
+        std::streamsize copied_ = 0;
+        Error interleaved(const Manifest& m);
+        Error watch();
+        Error arrive(const std::string& path);
+        Maybe<std::optional<Part>> locate(const std::string& name,
+            const Arrival& a);
+        std::optional<size_t> number(const std::string& name) const;
+        std::streamsize expected() const;
+        std::unordered_set<std::string> validArgs() const override;
 public:
         UtilAssembler() = default;
-        ~UtilAssembler() = default;
+        virtual ~UtilAssembler() = default;
         UtilAssembler(const UtilAssembler&) = delete;
         Error run() override;
         Error setArgs(const ArgMap& map) override;
@@ -16,10 +16,9 @@
 
 #include "src/UtilAssemblerMulti.hh"
 #include "src/utils.hh"
+#include "src/BufferPool.hh"
 #include "src/consts.hh"
-#include "src/Row.hh"
 #include <iostream>
-#include <fstream>
 
 Error UtilAssemblerMulti::setArgs(const ArgMap& map)
 {
@@ -35,6 +34,10 @@ Error UtilAssemblerMulti::setArgs(const ArgMap& map)
         }
         if (const auto e = setPath(map, OUT_A, out_))
                 return *e;
+        if (const auto e = setIOArgs(map))
+                return *e;
+        if (const auto e = setThreads(map, threadc_))
+                return *e;
         return NONE;
 }
 
@@ -45,21 +48,20 @@ Conflict UtilAssemblerMulti::conflicting() const
 
 Error UtilAssemblerMulti::run()
 {
+        silence_ = silence_ || out_ == STDOUT_PATH;
         if (!silence_)
                 std::cout << util::BANNER << "\nAssembling\n";
-        std::ofstream output(out_);
-        if (!output)
-                return "Failed to open: " + out_;
-        const auto bytes = writeStripe(files_, output, silence_);
-        if (!bytes)
-                return bytes.error();
-        if (!silence_)
-                Row::print(RIGHT, out_, *bytes);
-        return NONE;
+        BufferPool::instance().configure(io_);
+        const auto parts = layout(files_);
+        if (!parts)
+                return parts.error();
+        return assemble(*parts, out_, silence_, io_, threadc_);
 }
 
 Error UtilAssemblerMulti::setFlags(const ArgMap& map)
 {
+        if (const auto e = setIOFlags(map))
+                return *e;
         if (const auto m = validFlag(map, QUIET_F); m && *m)
                 silence_ = true;
         else if (!m)
@@ -70,8 +72,16 @@ Error UtilAssemblerMulti::setFlags(const ArgMap& map)
 std::unordered_set<std::string> UtilAssemblerMulti::validArgs() const
 {
         return {
-            "--input" , "-i",
-            "--output", "-o",
-            "--quiet" , "-q",
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--threads"        , "-t" ,
+            "--quiet"          , "-q" ,
+            "--streaming-cache", "-sc",
+            "--cache-window"   , "-cw",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sparse"         , "-sp",
+            "--sync"           , "-sy",
         };
 }
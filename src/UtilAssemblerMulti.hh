@@ -26,6 +26,7 @@ class UtilAssemblerMulti final : public UtilBase
 private:
         FilesL files_;
         std::string out_;
+        int threadc_ = 1;
         std::unordered_set<std::string> validArgs() const override;
         Conflict conflicting() const override;
 public:
@@ -17,6 +17,7 @@
 #include "src/UtilBase.hh"
 #include "src/utils.hh"
 #include "src/consts.hh"
+#include <algorithm>
 #include <filesystem>
 
 namespace fs = std::filesystem;
@@ -65,6 +66,132 @@ Error UtilBase::setMember(const ArgMap& map, const ArgT& opt,
         return setMemberBase(map, opt, ref, false);
 }
 
+Error UtilBase::setBytes(const ArgMap& map, const ArgT& opt, size_t& ref)
+{
+        std::string interim;
+        if (const auto e = setMemberBase(map, opt, interim, false))
+                return e;
+        if (interim.empty())
+                return NONE;
+        const auto bytes = util::stringToBytes(interim);
+        if (!bytes)
+                return bytes.error();
+        ref = *bytes;
+        return NONE;
+}
+
+Error UtilBase::setPaths(const ArgMap& map, const ArgT& opt,
+    std::vector<std::string>& ref)
+{
+        const auto mIt = argToIter(map, opt);
+        if (!mIt)
+                return mIt.error();
+        const auto it = *mIt;
+        if (it == map.end())
+                return "Missing " + std::get<2>(opt);
+        if (!it->second)
+                return "Unmatched " + std::get<2>(opt);
+        ref.clear();
+        for (auto p = it->second; p; p = p->next_)
+                ref.push_back(toPath(p->val_));
+        return NONE;
+}
+
+Error UtilBase::setThreads(const ArgMap& map, int& ref)
+{
+        const auto threads = argToIter(map, THREADS_A);
+        if (!threads)
+                return threads.error();
+        if (const auto it = *threads; it != map.end()) {
+                const auto ptr = it->second;
+                switch (ty::count(ptr)) {
+                case 0:
+                        return "No threads";
+                case 1: {
+                        const auto t = std::stoi(ptr->val_);
+                        if (t == 0)
+                                return "Can't have zero threads";
+                        ref = t;
+                        break;
+                }
+                default:
+                        return "Too many threads";
+                }
+        }
+        return NONE;
+}
+
+/// --shard k/N, this process is participant k of N, counted from 0
+Error UtilBase::setShard(const ArgMap& map, size_t& shard, size_t& shards)
+{
+        std::string val;
+        if (const auto e = setMember(map, SHARD_A, val))
+                return e;
+        if (val.empty())
+                return NONE;
+        const auto slash = val.find('/');
+        const auto k = val.substr(0, slash);
+        const auto n = slash == std::string::npos ? "" : val.substr(slash + 1);
+        const auto digits = [](const std::string& s) {
+                return !s.empty() && s.size() < 10
+                    && std::all_of(s.begin(), s.end(), util::isDigit);
+        };
+        if (!digits(k) || !digits(n))
+                return "Bad shard " + val + ", expected k/N";
+        shard = std::stoul(k);
+        shards = std::stoul(n);
+        if (!shards || shard >= shards)
+                return "Bad shard " + val + ", k must be below N";
+        return NONE;
+}
+
+Error UtilBase::setIOArgs(const ArgMap& map)
+{
+        size_t window = io_.window;
+        if (const auto e = setBytes(map, WINDOW_A, window))
+                return *e;
+        if (window == 0)
+                return "Can't have zero cache window";
+        io_.window = window;
+        std::string sync;
+        if (const auto e = setMember(map, SYNC_A, sync))
+                return *e;
+        if (sync == "end")
+                io_.sync = SyncMode::END;
+        else if (sync == "each")
+                io_.sync = SyncMode::EACH;
+        else if (sync == "batch")
+                io_.sync = SyncMode::BATCH;
+        else if (!sync.empty() && sync != "none")
+                return "Bad sync mode " + sync;
+        if (const auto e = setBytes(map, BUFFER_A, io_.bufferSize))
+                return *e;
+        if (io_.bufferSize < 4'096)
+                return "Buffer size too small";
+        if (const auto e = setBytes(map, MEMORY_A, io_.maxMemory))
+                return *e;
+        if (io_.maxMemory && io_.maxMemory < io_.bufferSize)
+                return "Max memory below buffer size";
+        return NONE;
+}
+
+Error UtilBase::setIOFlags(const ArgMap& map)
+{
+        if (const auto m = validFlag(map, STREAM_F); m && *m)
+                io_.streaming = true;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, HUGE_F); m && *m)
+                io_.hugePages = true;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, SPARSE_F); m && *m)
+                io_.sparse = true;
+        else if (!m)
+                return m.error();
+        return NONE;
+}
+
 Error UtilBase::setPath(const ArgMap& map, const ArgT& opt, std::string& ref)
 {
         std::string interim;
@@ -91,7 +218,7 @@ Error UtilBase::checkForUnknown(const ArgMap& map) const
 std::string UtilBase::toPath(const std::string& p) const
 {
         const std::string cwd = fs::current_path().string();
-        if (p.empty())
+        if (p.empty() || p == STDOUT_PATH)
                 return p;
         if (isSlash(p[0]))
                 return p;
@@ -19,8 +19,10 @@
 
 #include "src/Maybe.hh"
 #include "src/types.hh"
+#include "src/IOPolicy.hh"
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 class UtilBase {
 private:
@@ -28,10 +30,18 @@ private:
             std::string& ref, bool required);
 protected:
         bool silence_ = false;
+        IOPolicy io_;
         std::string toPath(const std::string& p) const;
         bool isSlash(const char c) const;
         Error setPath(const ArgMap& map, const ArgT& opt, std::string& ref);
         Error setMember(const ArgMap& map, const ArgT& opt, std::string& ref);
+        Error setBytes(const ArgMap& map, const ArgT& opt, size_t& ref);
+        Error setPaths(const ArgMap& map, const ArgT& opt,
+            std::vector<std::string>& ref);
+        Error setThreads(const ArgMap& map, int& ref);
+        Error setShard(const ArgMap& map, size_t& shard, size_t& shards);
+        Error setIOArgs(const ArgMap& map);
+        Error setIOFlags(const ArgMap& map);
         virtual std::unordered_set<std::string> validArgs() const = 0;
         Maybe<bool> validFlag(const ArgMap& map, const ArgOr& arg) const;
         Maybe<MapIt> argToIter(const ArgMap& map, const ArgT& arg) const;
@@ -0,0 +1,337 @@
+/**
+ * File: UtilExtract.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/UtilExtract.hh"
+#include "src/Row.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include "src/BufferPool.hh"
+#include "src/scan.hh"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+std::unordered_set<std::string> UtilExtract::validArgs() const
+{
+        return {
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--offset"         , "-of",
+            "--length"         , "-ln",
+            "--threads"        , "-t" ,
+            "--extension"      , "-e" ,
+            "--name"           , "-n" ,
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--no-name"        , "-nn",
+            "--header"         , "-hd",
+            "--set"            , "-ss",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sync"           , "-sy",
+        };
+}
+
+Error UtilExtract::setArgs(const ArgMap& map)
+{
+        if (const auto e = setPaths(map, IN_A, ins_))
+                return *e;
+        in_ = ins_.front();
+        if (const auto e = setMember(map, OUT_A, out_))
+                return *e;
+        if (!out_.empty())
+                out_ = toPath(out_);
+        if (const auto e = setIOArgs(map))
+                return *e;
+        if (const auto e = setMember(map, EXT_A, ext_))
+                return *e;
+        if (const auto e = setMember(map, NAME_A, name_))
+                return *e;
+        threadc_ = 4;
+        if (const auto e = setThreads(map, threadc_))
+                return *e;
+        if (const auto e = setBytes(map, OFFSET_A, offset_))
+                return *e;
+        if (const auto e = setBytes(map, LENGTH_A, length_))
+                return *e;
+        if (const auto e = setSet(map))
+                return *e;
+        return NONE;
+}
+
+/// every stripe of the set ordered by output offset, none when interleaved
+Maybe<Parts> UtilExtract::sorted(const std::string& path, const Manifest& m)
+    const
+{
+        const auto bundles = bundlePaths();
+        const auto headers = path.empty() && bundles.empty() && !header_
+            ? sniffed() : Maybe<bool>(false);
+        if (!headers)
+                return makeBad<Parts>(headers.error());
+        auto parts = !bundles.empty() ? bundled(bundles)
+            : m.interleave ? Maybe<Parts>(Parts())
+            : header_ || *headers ? headed()
+            : path.empty() ? discovered() : fromManifest(m);
+        if (!parts)
+                return makeBad<Parts>(parts.error());
+        auto sorted = parts.extract();
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a,
+            const auto& b) {
+                return a.to < b.to;
+        });
+        return sorted;
+}
+
+std::streamsize UtilExtract::total(const Parts& parts, const Manifest& m)
+    const
+{
+        std::streamsize total = m.size;
+        for (const auto& p : parts)
+                total = std::max<std::streamsize>(total, p.to + p.length);
+        return total;
+}
+
+/// offset and length compared without adding them, so neither can wrap
+Error UtilExtract::inRange(const std::streamsize total) const
+{
+        const auto size = static_cast<size_t>(std::max<std::streamsize>(0,
+            total));
+        if (offset_ >= size || length_ > size - offset_)
+                return "Range past the end of the file ("
+                    + std::to_string(total) + " bytes)";
+        return NONE;
+}
+
+/// Stripes laid end to end, found by binary search on their offsets so
+/// only the ones holding the range are touched.
+Maybe<std::vector<Fragment>> UtilExtract::fragments(const Parts& parts,
+    const std::streamsize total) const
+{
+        using Frags = std::vector<Fragment>;
+        if (const auto e = inRange(total))
+                return makeBad<Frags>(*e);
+        const off_t begin = offset_;
+        const off_t end = length_ ? begin + length_ : total;
+        auto it = std::upper_bound(parts.begin(), parts.end(), begin,
+            [](const off_t at, const Part& p) {
+                return at < p.to;
+        });
+        if (it != parts.begin())
+                it = std::prev(it);
+        Frags frags;
+        for (; it != parts.end() && it->to < end; it++) {
+                const auto from = std::max(begin, it->to);
+                const auto to = std::min(end, it->to + it->length);
+                if (from < to)
+                        frags.push_back({ it->path, it->from + from - it->to,
+                            from - begin, to - from, it->stored, it->file });
+        }
+        return frags;
+}
+
+/// An interleaved set has one fragment per unit touched
+Maybe<std::vector<Fragment>> UtilExtract::fragments(const Manifest& m) const
+{
+        using Frags = std::vector<Fragment>;
+        auto entries = m.entries;
+        std::sort(entries.begin(), entries.end(), [](const auto& a,
+            const auto& b) {
+                return a.index < b.index;
+        });
+        if (entries.size() != m.interleave)
+                return makeBad<Frags>("Interleaved set needs "
+                    + std::to_string(m.interleave) + " files");
+        std::vector<std::string> paths;
+        for (const auto& e : entries) {
+                const auto p = findStripe(m, e);
+                if (!p)
+                        return makeBad<Frags>(p.error());
+                paths.push_back(*p);
+        }
+        if (const auto e = inRange(m.size))
+                return makeBad<Frags>(*e);
+        const off_t begin = offset_;
+        const off_t end = length_ ? begin + length_ : m.size;
+        const off_t n = m.interleave;
+        const off_t unit = m.unit;
+        Frags frags;
+        for (off_t at = begin; at < end; ) {
+                const auto block = at / unit;
+                const auto within = at % unit;
+                const auto length = std::min(unit - within, end - at);
+                frags.push_back({ paths[block % n],
+                    (block / n) * unit + within, at - begin, length, 0 });
+                at += length;
+        }
+        return frags;
+}
+
+/// pieces no larger than a pool buffer so threads share long fragments
+std::vector<Fragment> UtilExtract::chunked(
+    const std::vector<Fragment>& frags) const
+{
+        const std::streamsize most = BufferPool::instance().size();
+        std::vector<Fragment> chunks;
+        for (const auto& f : frags) {
+                for (std::streamsize at = 0; at < f.length; at += most) {
+                        auto c = f;
+                        c.from += at;
+                        c.to += at;
+                        c.length = std::min(most, f.length - at);
+                        chunks.push_back(c);
+                }
+        }
+        return chunks;
+}
+
+/// Threads take the next chunk and read it into their own pool buffer, held
+/// for the whole run so --max-memory only limits how many read. A file
+/// gets it written in place at once, all zero chunks left as holes under
+/// --sparse, a stream waits for its turn so at most one chunk per thread is
+/// held back.
+Error UtilExtract::fetch(const std::vector<Fragment>& chunks,
+    const FileDesc& out, const bool stream, const int threads)
+{
+        std::atomic<size_t> next = 0;
+        std::mutex mtx;
+        BlockIndexes indexes;
+        const auto work = [&]() {
+                auto codec = Codec::create(compression_);
+                if (!codec) {
+                        fail(codec.error());
+                        return;
+                }
+                const auto buffer = BufferPool::instance().checkout();
+                if (!buffer)
+                        fail("Failed to map i/o buffer");
+                for (size_t i; (i = next++) < chunks.size() && !failure_; ) {
+                        const auto& c = chunks[i];
+                        const auto own = c.file ? Maybe<FileDesc>(FileDesc())
+                                                : FileDesc::openRead(c.path);
+                        if (!own) {
+                                fail(own.error());
+                                break;
+                        }
+                        const auto in = c.file ? c.file.get() : &*own;
+                        if (c.stored) {
+                                const auto index = indexes.get(*in, c.stored);
+                                if (!index) {
+                                        fail(index.error());
+                                        break;
+                                }
+                                if (const auto e = (*codec)->extract(*in,
+                                    **index, c.from, c.length,
+                                    buffer.data())) {
+                                        fail(*e);
+                                        break;
+                                }
+                        } else if (const auto r = in->readAt(buffer.data(),
+                            c.length, c.from); !r || *r != c.length) {
+                                fail(r ? "Stripe too short: " + c.path
+                                       : r.error());
+                                break;
+                        }
+                        if (!stream) {
+                                if (io_.sparse && scan::zero(buffer.data(),
+                                    c.length))
+                                        continue;
+                                if (const auto e = out.writeAt(buffer.data(),
+                                    c.length, c.to)) {
+                                        fail(*e);
+                                        break;
+                                }
+                                continue;
+                        }
+                        std::unique_lock<std::mutex> lock(mtx);
+                        turn_.wait(lock, [&] {
+                                return written_ == i || failure_;
+                        });
+                        if (failure_)
+                                break;
+                        for (std::streamsize at = 0; at < c.length; ) {
+                                const auto w = ::write(out.get(),
+                                    buffer.data() + at, c.length - at);
+                                if (w == -1 && errno == EINTR)
+                                        continue;
+                                if (w == -1) {
+                                        fail(util::sysError("Write failed",
+                                            out.path()));
+                                        break;
+                                }
+                                at += w;
+                        }
+                        written_++;
+                        turn_.notify_all();
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                turn_.notify_all();
+        };
+        const auto t = std::min<size_t>(std::max(1, threads), chunks.size());
+        std::vector<std::thread> pool;
+        for (size_t i = 1; i < t; i++)
+                pool.emplace_back(work);
+        work();
+        for (auto& th : pool)
+                th.join();
+        if (failure_)
+                return fmsg_;
+        return NONE;
+}
+
+Error UtilExtract::run()
+{
+        const bool stream = out_.empty();
+        silence_ = silence_ || stream;
+        if (!silence_)
+                std::cout << util::BANNER << "\nExtracting\n";
+        BufferPool::instance().configure(io_);
+        const auto path = manifestPath();
+        const auto m = path.empty() ? Maybe<Manifest>(Manifest())
+                                    : Manifest::read(path);
+        if (!m)
+                return m.error();
+        if (m->indexOnly)
+                return "Index only set, use --Materialize";
+        if (const auto e = useCodec(*m))
+                return *e;
+        const auto parts = sorted(path, *m);
+        if (!parts)
+                return parts.error();
+        const auto frags = m->interleave ? fragments(*m)
+                                         : fragments(*parts, total(*parts, *m));
+        if (!frags)
+                return frags.error();
+        const auto chunks = chunked(*frags);
+        std::streamsize bytes = 0;
+        for (const auto& c : chunks)
+                bytes += c.length;
+        if (stream) {
+                const FileDesc out(::dup(STDOUT_FILENO), "stdout");
+                if (!out)
+                        return util::sysError("Failed to open", "stdout");
+                return fetch(chunks, out, true, threadc_);
+        }
+        return output(bytes, out_, silence_, io_, [&](const FileDesc& fd) {
+                if (const auto e = fetch(chunks, fd, false, threadc_))
+                        return makeBad<std::streamsize>(*e);
+                if (!silence_)
+                        for (const auto& f : *frags)
+                                Row::print(LEFT, f.path, f.length);
+                return Maybe<std::streamsize>(bytes);
+        });
+}
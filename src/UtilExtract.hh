@@ -0,0 +1,60 @@
+/**
+ * File: UtilExtract.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef UTIL_EXTRACT_HH
+#define UTIL_EXTRACT_HH
+
+#include "src/UtilAssembler.hh"
+#include <condition_variable>
+
+/// bytes of one stripe that land in the extracted range
+struct Fragment {
+        std::string path;
+        off_t from = 0; /// raw offset in the stripe
+        off_t to = 0;   /// in the extracted range
+        std::streamsize length = 0;
+        std::streamsize stored = 0; /// packed stripe size, 0 when raw
+        std::shared_ptr<const FileDesc> file = nullptr; /// open, shared
+};
+
+/// Reads a byte range of the original file straight from its stripes.
+class UtilExtract : public UtilAssembler {
+private:
+        std::condition_variable turn_;
+        size_t written_ = 0; /// chunks written to a stream, in order
+        std::unordered_set<std::string> validArgs() const override;
+protected:
+        size_t offset_ = 0;
+        size_t length_ = 0; /// 0 runs to the end
+        Maybe<Parts> sorted(const std::string& path, const Manifest& m) const;
+        std::streamsize total(const Parts& parts, const Manifest& m) const;
+        Error inRange(const std::streamsize total) const;
+        Maybe<std::vector<Fragment>> fragments(const Parts& parts,
+            const std::streamsize total) const;
+        Maybe<std::vector<Fragment>> fragments(const Manifest& m) const;
+        std::vector<Fragment> chunked(const std::vector<Fragment>& frags)
+            const;
+        Error fetch(const std::vector<Fragment>& chunks, const FileDesc& out,
+            const bool stream, const int threads);
+public:
+        UtilExtract() = default;
+        virtual ~UtilExtract() = default;
+        UtilExtract(const UtilExtract&) = delete;
+        Error run() override;
+        Error setArgs(const ArgMap& map) override;
+};
+
+#endif /// UTIL_EXTRACT_HH
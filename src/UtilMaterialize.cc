@@ -0,0 +1,128 @@
+/**
+ * File: UtilMaterialize.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/UtilMaterialize.hh"
+#include "src/Row.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include "src/BufferPool.hh"
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unordered_set<std::string> UtilMaterialize::validArgs() const
+{
+        return {
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--stripe"         , "-k" ,
+            "--threads"        , "-t" ,
+            "--name"           , "-n" ,
+            "--quiet"          , "-q" ,
+            "--no-name"        , "-nn",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sync"           , "-sy",
+        };
+}
+
+Error UtilMaterialize::setArgs(const ArgMap& map)
+{
+        if (const auto e = setPaths(map, IN_A, ins_))
+                return *e;
+        in_ = ins_.front();
+        if (const auto e = setMember(map, OUT_A, out_))
+                return *e;
+        if (!out_.empty())
+                out_ = toPath(out_);
+        if (const auto e = setIOArgs(map))
+                return *e;
+        if (const auto e = setMember(map, NAME_A, name_))
+                return *e;
+        threadc_ = 4;
+        if (const auto e = setThreads(map, threadc_))
+                return *e;
+        std::string stripe;
+        if (const auto e = setMember(map, STRIPE_A, stripe))
+                return *e;
+        if (stripe.empty())
+                return "Missing stripe, use -k";
+        if (stripe.size() >= 10
+            || !std::all_of(stripe.begin(), stripe.end(), util::isDigit))
+                return "Bad stripe " + stripe;
+        stripe_ = std::stoull(stripe);
+        return NONE;
+}
+
+/// the source must still be the file that was indexed, a stripe cut from a
+/// rewritten file would silently hold the wrong bytes
+Error UtilMaterialize::identical(const Manifest& m) const
+{
+        struct stat st;
+        if (::stat(m.source.c_str(), &st) == -1)
+                return util::sysError("stat", m.source);
+        const long long mtime = st.st_mtim.tv_sec * 1'000'000'000LL
+            + st.st_mtim.tv_nsec;
+        if (st.st_ino != m.inode || mtime != m.mtime || st.st_size != m.size)
+                return "Source changed since indexing: " + m.source;
+        return NONE;
+}
+
+Error UtilMaterialize::run()
+{
+        const bool stream = out_.empty();
+        silence_ = silence_ || stream;
+        if (!silence_)
+                std::cout << util::BANNER << "\nMaterializing\n";
+        BufferPool::instance().configure(io_);
+        const auto path = manifestPath();
+        if (path.empty())
+                return "No index in " + in_;
+        const auto m = Manifest::read(path);
+        if (!m)
+                return m.error();
+        if (!m->indexOnly)
+                return "Not an index only set: " + path;
+        if (const auto e = identical(*m))
+                return *e;
+        const auto it = std::find_if(m->entries.begin(), m->entries.end(),
+            [&](const auto& e) {
+                return e.index == stripe_;
+        });
+        if (it == m->entries.end())
+                return "No stripe " + std::to_string(stripe_) + " in "
+                    + std::to_string(m->entries.size());
+        const std::vector<Fragment> whole = {
+            { m->source, it->offset, 0, it->length, 0 }
+        };
+        const auto chunks = chunked(whole);
+        if (stream) {
+                const FileDesc out(::dup(STDOUT_FILENO), "stdout");
+                if (!out)
+                        return util::sysError("Failed to open", "stdout");
+                return fetch(chunks, out, true, threadc_);
+        }
+        return output(it->length, out_, silence_, io_,
+            [&](const FileDesc& fd) {
+                if (const auto e = fetch(chunks, fd, false, threadc_))
+                        return makeBad<std::streamsize>(*e);
+                if (!silence_)
+                        Row::print(LEFT, m->source, it->length);
+                return Maybe<std::streamsize>(it->length);
+        });
+}
@@ -0,0 +1,36 @@
+/**
+ * File: UtilMaterialize.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef UTIL_MATERIALIZE_HH
+#define UTIL_MATERIALIZE_HH
+
+#include "src/UtilExtract.hh"
+
+/// Copies one stripe of an --index-only set out of its source file.
+class UtilMaterialize final : public UtilExtract {
+private:
+        size_t stripe_ = 0;
+        std::unordered_set<std::string> validArgs() const override;
+        Error identical(const Manifest& m) const;
+public:
+        UtilMaterialize() = default;
+        ~UtilMaterialize() = default;
+        UtilMaterialize(const UtilMaterialize&) = delete;
+        Error run() override;
+        Error setArgs(const ArgMap& map) override;
+};
+
+#endif /// UTIL_MATERIALIZE_HH
@@ -0,0 +1,254 @@
+/**
+ * File: UtilRestripe.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/UtilRestripe.hh"
+#include "src/Row.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include "src/BufferPool.hh"
+#include "src/Durability.hh"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+std::unordered_set<std::string> UtilRestripe::validArgs() const
+{
+        return {
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--size"           , "-s" ,
+            "--parts"          , "-p" ,
+            "--threads"        , "-t" ,
+            "--extension"      , "-e" ,
+            "--name"           , "-n" ,
+            "--out-extension"  , "-oe",
+            "--out-name"       , "-on",
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--no-name"        , "-nn",
+            "--no-padding"     , "-np",
+            "--manifest"       , "-m" ,
+            "--header"         , "-hd",
+            "--set"            , "-ss",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sparse"         , "-sp",
+            "--sync"           , "-sy",
+        };
+}
+
+Conflict UtilRestripe::conflicting() const
+{
+        auto c = UtilAssembler::conflicting();
+        c.push_back({
+            { "--parts", "-p" },
+            { "--size", "-s" },
+            "Parts and Size not possible"
+        });
+        return c;
+}
+
+Error UtilRestripe::setArgs(const ArgMap& map)
+{
+        if (const auto e = setPaths(map, IN_A, ins_))
+                return *e;
+        in_ = ins_.front();
+        if (const auto e = setPaths(map, OUT_A, outs_))
+                return *e;
+        out_ = outs_.front();
+        if (const auto e = setIOArgs(map))
+                return *e;
+        if (const auto e = setMember(map, EXT_A, ext_))
+                return *e;
+        if (const auto e = setMember(map, NAME_A, name_))
+                return *e;
+        outExt_ = ext_;
+        outName_ = name_;
+        if (const auto e = setMember(map, OUT_EXT_A, outExt_))
+                return *e;
+        if (const auto e = setMember(map, OUT_NAME_A, outName_))
+                return *e;
+        threadc_ = 4;
+        if (const auto e = setThreads(map, threadc_))
+                return *e;
+        if (const auto e = setBytes(map, SIZE_A, size_))
+                return *e;
+        std::string parts;
+        if (const auto e = setMember(map, PARTS_A, parts))
+                return *e;
+        if (parts.size() >= 10
+            || !std::all_of(parts.begin(), parts.end(), util::isDigit))
+                return "Bad Parts " + parts;
+        if (!parts.empty())
+                parts_ = std::stoull(parts);
+        if (!size_ && !parts_)
+                return "Missing size or parts";
+        if (const auto e = setSet(map))
+                return *e;
+        return NONE;
+}
+
+Error UtilRestripe::setFlags(const ArgMap& map)
+{
+        if (const auto e = UtilAssembler::setFlags(map))
+                return *e;
+        if (const auto m = validFlag(map, NO_PAD_F); m && *m)
+                padding_ = false;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, MANIFEST_F); m && *m)
+                manifest_ = true;
+        else if (!m)
+                return m.error();
+        return NONE;
+}
+
+/// New stripes are written while old ones are still read, and old ones left
+/// beside new ones would be picked up by a later -A, so no output directory
+/// may hold any part of the input set.
+Error UtilRestripe::apart(const Parts& parts) const
+{
+        std::vector<fs::path> dirs(ins_.begin(), ins_.end());
+        for (const auto& p : parts)
+                dirs.push_back(fs::path(p.path).parent_path());
+        for (const auto& out : outs_)
+                for (const auto& dir : dirs) {
+                        std::error_code ec;
+                        if (fs::equivalent(out, dir, ec))
+                                return "Output directory holds the input set: "
+                                    + out;
+                }
+        return NONE;
+}
+
+Error UtilRestripe::run()
+{
+        if (!silence_)
+                std::cout << util::BANNER << "\nRestriping\n";
+        BufferPool::instance().configure(io_);
+        for (const auto& dir : outs_)
+                if (!fs::is_directory(dir))
+                        return "Bad output directory " + dir;
+        const auto path = manifestPath();
+        const auto m = path.empty() ? Maybe<Manifest>(Manifest())
+                                    : Manifest::read(path);
+        if (!m)
+                return m.error();
+        if (m->indexOnly)
+                return "Index only set, use --Materialize";
+        if (const auto e = useCodec(*m))
+                return *e;
+        const auto parts = sorted(path, *m);
+        if (!parts)
+                return parts.error();
+        if (const auto e = apart(*parts))
+                return *e;
+        const auto size = m->interleave ? m->size : total(*parts, *m);
+        if (size == 0)
+                return "No Pieces";
+        const std::streamsize stripe = size_ ? size_
+            : size / parts_ + (size % parts_ > 0);
+        if (stripe < 4'000)
+                return "Stripe size too small";
+        const size_t count = size / stripe + (size % stripe > 0);
+        std::vector<std::uintmax_t> need(outs_.size(), 0);
+        for (size_t i = 0; i < count; i++)
+                need[i % outs_.size()] += std::min<std::streamsize>(stripe,
+                    size - i * stripe);
+        for (size_t d = 0; d < outs_.size(); d++)
+                if (const auto e = util::checkSpace(outs_[d], need[d]))
+                        return *e;
+        Manifest out;
+        out.source = m->source;
+        out.size = size;
+        out.dirs = outs_;
+        /// fragments read offset_ and length_, so they are cut up front
+        std::vector<std::vector<Fragment>> chunks;
+        for (size_t i = 0; i < count; i++) {
+                offset_ = i * stripe;
+                length_ = std::min<std::streamsize>(stripe, size - offset_);
+                const auto frags = m->interleave ? fragments(*m)
+                                                 : fragments(*parts, size);
+                if (!frags)
+                        return frags.error();
+                chunks.push_back(chunked(*frags));
+                out.entries.push_back({ i, static_cast<off_t>(offset_),
+                    static_cast<std::streamsize>(length_), 0,
+                    i % outs_.size(), "" });
+        }
+        /// named like -S names them, -ne drops the extension on both sides
+        const auto digits = std::to_string(count - 1).size();
+        for (auto& e : out.entries)
+                e.name = fs::path(util::stripePath(outs_[e.dir], outName_,
+                    e.index, digits, padding_, useExt_ ? outExt_ : ""))
+                    .filename().string();
+        /// many small stripes are written side by side, a few large ones
+        /// share the threads between their chunks
+        Durability dur(io_.sync);
+        const auto outer = std::min<size_t>(std::max(1, threadc_), count);
+        const auto inner = std::max<int>(1, threadc_ / outer);
+        std::atomic<size_t> next = 0;
+        std::mutex rows; /// std::cout
+        const auto work = [&]() {
+                for (size_t i; (i = next++) < count && !failure_; ) {
+                        const auto& e = out.entries[i];
+                        const auto name = (fs::path(outs_[e.dir]) / e.name)
+                            .string();
+                        auto file = FileDesc::openWrite(name);
+                        if (!file) {
+                                fail(file.error());
+                                return;
+                        }
+                        if (const auto err = file->allocate(e.length,
+                            io_.sparse)) {
+                                fail(*err);
+                                return;
+                        }
+                        /// fetch records its own failure
+                        if (fetch(chunks[i], *file, false, inner))
+                                return;
+                        if (const auto err = dur.settle(file.extract())) {
+                                fail(*err);
+                                return;
+                        }
+                        if (!silence_) {
+                                std::lock_guard<std::mutex> lock(rows);
+                                Row::print(RIGHT, name, e.length);
+                        }
+                }
+        };
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < outer; t++)
+                pool.emplace_back(work);
+        work();
+        for (auto& th : pool)
+                th.join();
+        if (failure_)
+                return fmsg_;
+        if (manifest_ || outs_.size() > 1) {
+                const bool durable = io_.sync != SyncMode::NONE;
+                for (const auto& dir : outs_)
+                        if (const auto e = out.write(fs::path(dir)
+                            / Manifest::fileName(outName_), durable))
+                                return e;
+        }
+        if (const auto e = dur.finish(outs_))
+                return *e;
+        if (!silence_ && io_.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
+}
@@ -0,0 +1,45 @@
+/**
+ * File: UtilRestripe.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef UTIL_RESTRIPE_HH
+#define UTIL_RESTRIPE_HH
+
+#include "src/UtilExtract.hh"
+
+/// Cuts an existing set into a new one. Every new stripe is filled straight
+/// from the ranges of the old stripes it overlaps.
+class UtilRestripe final : public UtilExtract {
+private:
+        std::vector<std::string> outs_;
+        size_t size_ = 0;
+        size_t parts_ = 0;
+        std::string outName_;
+        std::string outExt_;
+        bool padding_ = true;
+        bool manifest_ = false;
+        std::unordered_set<std::string> validArgs() const override;
+        Conflict conflicting() const override;
+        Error apart(const Parts& parts) const;
+public:
+        UtilRestripe() = default;
+        ~UtilRestripe() = default;
+        UtilRestripe(const UtilRestripe&) = delete;
+        Error run() override;
+        Error setArgs(const ArgMap& map) override;
+        Error setFlags(const ArgMap& map) override;
+};
+
+#endif /// UTIL_RESTRIPE_HH
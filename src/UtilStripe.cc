@@ -15,27 +15,40 @@
  */
 
 #include "src/UtilStripe.hh"
-#include "src/Maybe.hh"
-#include "src/types.hh"
 #include "src/utils.hh"
 #include "src/consts.hh"
-#include <cctype>
-#include <cstddef>
-#include <unordered_map>
-#include <algorithm>
 
 std::unordered_set<std::string> UtilStripe::validArgs() const
 {
         return {
-            "--input"       , "-i" ,
-            "--output"      , "-o" ,
-            "--size"        , "-s" ,
-            "--name"        , "-n" ,
-            "--extension"   , "-e" ,
-            "--no-padding"  , "-np",
-            "--quiet"       , "-q" ,
-            "--no-extension", "-ne",
-            "--threads"     , "-t" ,
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--size"           , "-s" ,
+            "--records"        , "-r" ,
+            "--name"           , "-n" ,
+            "--extension"      , "-e" ,
+            "--no-padding"     , "-np",
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--threads"        , "-t" ,
+            "--placement"      , "-pl",
+            "--manifest"       , "-m" ,
+            "--compress"       , "-z" ,
+            "--store"          , "-st",
+            "--index-only"     , "-io",
+            "--header"         , "-hd",
+            "--bundle"         , "-bd",
+            "--shard"          , "-sh",
+            "--ordered"        , "-or",
+            "--follow"         , "-f" ,
+            "--idle"           , "-id",
+            "--streaming-cache", "-sc",
+            "--cache-window"   , "-cw",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sparse"         , "-sp",
+            "--sync"           , "-sy",
         };
 }
 
@@ -43,60 +56,11 @@ Error UtilStripe::setArgs(const ArgMap& map)
 {
         if (const auto e = UtilStripeBase::setArgs(map))
                 return *e;
-        const auto size = argToIter(map, SIZE_A);
-        if (!size)
-                return size.error();
-        if (const auto it = *size; it != map.end()) {
-                const auto args = it->second;
-                switch (ty::count(args)) {
-                case 0:
-                        return "No size";
-                case 1: {
-                        const auto &size = args->val_;
-                        const auto bytes = stringToBytes(size);
-                        if (bytes)
-                                stripeSize_ = *bytes;
-                        else
-                                return bytes.error();
-                        break;
-                }
-                default:
-                        return "Too many sizes";
-                }
-        }
+        if (const auto e = setBytes(map, SIZE_A, stripeSize_))
+                return *e;
         return NONE;
 }
 
-Maybe<size_t> UtilStripe::stringToBytes(const std::string& size) const
-{
-        auto it = size.begin();
-        while (it != size.end() && (util::isDigit(*it) || *it == '.'))
-                it++;
-        const std::string num(size.begin(), it);
-        const auto d = std::count_if(num.begin(), num.end(), [](const auto c) {
-                return c == '.';
-        });
-        if (num.empty() || d > 1 || (it != size.end() && !util::isAlpha(*it)))
-                return makeBad<size_t>("Bad byte size");
-        const std::unordered_map<std::string, size_t> map = {
-            { "b" , 1 },
-            { "kb", 1'000 },
-            { "mb", 1'000'000 },
-            { "gb", 1'000'000'000 },
-        };
-        using util::mapv;
-        const auto suffix = mapv<std::string>(it, size.end(), [](const auto c) {
-                return std::tolower(c);
-        });
-        const auto itr = map.find(suffix);
-        const auto found = itr != map.end();
-        if (!suffix.empty() && !found)
-                return makeBad<size_t>("Bad suffix: " + suffix);
-        const size_t units = found ? itr->second : 1;
-        const double dbytes = std::stod(num) * units;
-        return static_cast<size_t>(dbytes);
-}
-
 size_t UtilStripe::getStripeSize(const size_t&) const
 {
         return stripeSize_;
@@ -15,15 +15,24 @@
  */
 
 #include "src/UtilStripeBase.hh"
-#include "IOBuffer.hh"
+#include "src/IOBuffer.hh"
 #include "src/utils.hh"
+#include "src/BufferPool.hh"
 #include "src/Row.hh"
+#include "src/scan.hh"
+#include "src/Watcher.hh"
+#include "src/Sha256.hh"
+#include "src/Bundle.hh"
 #include "src/consts.hh"
 #include <iostream>
 #include <filesystem>
-#include <fstream>
 #include <thread>
 #include <algorithm>
+#include <cctype>
+#include <unordered_map>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 namespace fs = std::filesystem;
 
@@ -54,121 +63,1002 @@ size_t UtilStripeBase::getStripes(const std::streamsize& size,
         return size / stripeSize + (size % stripeSize > 0);
 }
 
-std::string UtilStripeBase::fileName(const int& number, const size_t& len) const
+std::string UtilStripeBase::stripePath(const size_t& num, const size_t& max,
+    const std::string& out) const
 {
-        const std::string strn = std::to_string(number);
-        const int diff = static_cast<int>(len) - static_cast<int>(strn.size());
-        const int zeros = padding_ ? std::max(0, diff) : 0;
-        const std::string paddingZeros(zeros, '0');
-        return name_ + (!name_.empty() ? "_" : "") + paddingZeros + strn;
+        return util::stripePath(out, name_, num, max, padding_,
+            useExt_ ? ext_ : "");
 }
 
-std::string UtilStripeBase::stripePath(const size_t& num, const size_t& max,
-    const std::string& out) const
+std::vector<Stripe> UtilStripeBase::fromCuts(const std::vector<off_t>& cuts,
+    const std::streamsize& fsize) const
 {
-        const auto name = fileName(num, max);
-        const std::string fullName = useExt_ ? (name + "." + ext_) : name;
-        const std::string path = fs::path(out) / fullName;
-        return path;
+        std::vector<Stripe> stripes;
+        for (size_t i = 0; i < cuts.size(); i++) {
+                const off_t end = i + 1 < cuts.size() ? cuts[i + 1] : fsize;
+                stripes.push_back({ cuts[i], end - cuts[i], "" });
+        }
+        return stripes;
 }
 
-std::vector<int> UtilStripeBase::fileIndex(const size_t& stripes) const
+/// offset just past the first delimiter at or after `from`, fsize if none
+Maybe<off_t> UtilStripeBase::nextRecord(const FileDesc& file, off_t from,
+    const std::streamsize& fsize) const
 {
-        const int base = stripes / threadc_;
-        const int rem = stripes % threadc_;
-        std::vector<int> quant(threadc_, base);
-        for (int i = 0; i < rem; i++)
-                quant[i]++;
-        quant.erase(
-            std::remove_if(quant.begin(), quant.end(), [](const auto& x) {
-                    return x == 0;
-            }),
-            quant.end());
-        std::vector<int> index = { 0 };
-        for (const auto& x : quant)
-                index.push_back(index.back() + x);
-        return index;
+        auto buffer = BufferPool::instance().checkout();
+        if (!buffer)
+                return makeBad<off_t>("Failed to map i/o buffer");
+        while (from < fsize) {
+                const auto use = std::min(buffer.size(), fsize - from);
+                const auto read = file.readAt(buffer.data(), use, from);
+                if (!read)
+                        return makeBad<off_t>(read.error());
+                if (!*read)
+                        break;
+                const auto at = scan::find(buffer.data(), *read, delim_);
+                if (at < static_cast<size_t>(*read))
+                        return from + static_cast<off_t>(at) + 1;
+                from += *read;
+        }
+        return static_cast<off_t>(fsize);
 }
 
-Maybe<IFiles> UtilStripeBase::files(const std::vector<int>& start,
-    const size_t& s) const
+/// Fixed size cuts, each moved forward past the next delimiter in records
+/// mode. Cuts that run into the next one are merged.
+Maybe<std::vector<Stripe>> UtilStripeBase::plan(const FileDesc& file,
+    const std::streamsize& fsize) const
 {
-        std::vector<std::ifstream> descriptors;
-        for (const auto& x : start) {
-                descriptors.emplace_back(in_, std::ios::binary);
-                auto& d = descriptors.back();
-                if (!d)
-                        return makeBad<IFiles>("Invalid File");
-                d.seekg(x * s);
+        const auto stripeSize = getStripeSize(fsize);
+        if (stripeSize < 4'000)
+                return makeBad<std::vector<Stripe>>("Stripe size too small");
+        const auto count = getStripes(fsize, stripeSize);
+        std::vector<off_t> cuts = { 0 };
+        for (size_t i = 1; i < count; i++) {
+                off_t at = i * stripeSize;
+                if (records_) {
+                        if (at <= cuts.back())
+                                continue;
+                        const auto next = nextRecord(file, at - 1, fsize);
+                        if (!next)
+                                return makeBad<std::vector<Stripe>>(
+                                    next.error());
+                        at = *next;
+                }
+                if (at < fsize)
+                        cuts.push_back(at);
         }
-        return descriptors;
+        return fromCuts(cuts, fsize);
 }
 
-void UtilStripeBase::worker(std::ifstream& file, const WD& data)
+/// Assigns every stripe an output directory, round robin or to whichever
+/// directory has the most free space left, and checks each one can hold
+/// what it was given.
+Error UtilStripeBase::place()
 {
-        auto [start, end, len, size] = data;
-        IOBuffer buffer;
-        while (!failure_ && start < end) {
-                const auto path = stripePath(start++, len, out_);
-                std::ofstream outFile(path);
-                if (!outFile) {
-                        fail("Error " + path);
-                        return;
+        std::vector<std::uintmax_t> avail;
+        for (const auto& dir : outs_) {
+                const auto space = util::freeSpace(dir);
+                if (!space)
+                        return space.error();
+                avail.push_back(*space);
+        }
+        std::vector<std::uintmax_t> need(outs_.size(), 0);
+        const auto length = numberLength(stripes_.size() - 1);
+        for (size_t i = 0; i < stripes_.size(); i++) {
+                auto& st = stripes_[i];
+                if (placement_ == Placement::CAPACITY) {
+                        size_t best = 0;
+                        for (size_t d = 1; d < outs_.size(); d++)
+                                if (avail[d] - need[d]
+                                    > avail[best] - need[best])
+                                        best = d;
+                        st.dir = best;
+                } else {
+                        st.dir = i % outs_.size();
                 }
-                const auto bytes = buffer.chunk(file, outFile, size);
-                if (!bytes)
-                        break;
+                st.path = stripePath(i, length, outs_[st.dir]);
+                if (!mine(i))
+                        continue;
+                if (need[st.dir] + st.length > avail[st.dir])
+                        return "Not enough space in " + outs_[st.dir];
+                need[st.dir] += st.length;
+        }
+        return NONE;
+}
+
+/// Splits the bytes of a group of stripes into one contiguous range per
+/// thread. Cuts snap to stripe boundaries when there are at least as many
+/// stripes as threads, otherwise stripes are split and copied by several
+/// threads at once.
+std::vector<std::vector<Piece>> UtilStripeBase::schedule(
+    const std::vector<size_t>& members, const int threads)
+{
+        constexpr std::streamsize align = 1'024 * 1'024;
+        std::vector<std::streamsize> at = { 0 };
+        for (const auto m : members)
+                at.push_back(at.back() + stripes_[m].length);
+        const auto total = at.back();
+        const std::streamsize t = std::max(1, threads);
+        const auto even = (total + t - 1) / t;
+        const auto share = std::max(align, (even + align - 1) / align * align);
+        const bool snap = members.size() >= static_cast<size_t>(t);
+        const auto cut = [&](std::streamsize pos) {
+                if (!snap || pos >= total)
+                        return std::min(pos, total);
+                const auto it = std::lower_bound(at.begin(), at.end(), pos);
+                if (*it == pos)
+                        return pos;
+                const auto prev = *std::prev(it);
+                return pos - prev < *it - pos ? prev : *it;
+        };
+        std::vector<std::vector<Piece>> work;
+        size_t s = 0;
+        for (std::streamsize i = 0; i < t; i++) {
+                const auto begin = cut(i * share);
+                const auto end = cut((i + 1) * share);
+                if (begin >= end)
+                        continue;
+                std::vector<Piece> pieces;
+                while (s < members.size() && at[s + 1] <= begin)
+                        s++;
+                for (auto j = s; j < members.size() && at[j] < end; j++) {
+                        const auto lo = std::max(begin, at[j]);
+                        const auto hi = std::min(end, at[j + 1]);
+                        pieces.push_back({ members[j], lo - at[j], hi - lo });
+                        pending_[members[j]]++;
+                }
+                work.push_back(std::move(pieces));
+        }
+        return work;
+}
+
+/// One worker group per output directory so a slow device only holds up
+/// the threads writing to it.
+std::vector<std::vector<Piece>> UtilStripeBase::groups()
+{
+        const int dirs = outs_.size();
+        std::vector<std::vector<size_t>> members(dirs);
+        for (size_t i = 0; i < stripes_.size(); i++)
+                if (mine(i))
+                        members[stripes_[i].dir].push_back(i);
+        std::vector<std::vector<Piece>> work;
+        for (int d = 0; d < dirs; d++) {
+                if (members[d].empty())
+                        continue;
+                const int t = std::max(1, threadc_ / dirs
+                    + (d < threadc_ % dirs));
+                for (auto& w : schedule(members[d], t))
+                        work.push_back(std::move(w));
+        }
+        for (size_t j = 0; j < stripes_.size(); j++)
+                stripes_[j].shared = pending_[j] > 1;
+        return work;
+}
+
+/// Single queue in file order for --ordered and --compress. Split stripes
+/// are cut into as many pieces as there are threads so the whole pool works
+/// on the front of the file first, compressed ones are taken whole since
+/// their size on disk is only known once written, headed ones since their
+/// checksum is taken in order.
+std::vector<Piece> UtilStripeBase::ordered(const bool split)
+{
+        constexpr std::streamsize align = 1'024 * 1'024;
+        const std::streamsize t = split ? std::max(1, threadc_) : 1;
+        std::vector<Piece> queue;
+        for (size_t i = 0; i < stripes_.size(); i++) {
+                if (!mine(i))
+                        continue;
+                const auto length = stripes_[i].length;
+                const auto even = (length + t - 1) / t;
+                const auto share = split ? std::max(align,
+                    (even + align - 1) / align * align) : length;
+                for (std::streamsize at = 0; at < length; at += share) {
+                        queue.push_back({ i, at,
+                            std::min(share, length - at) });
+                        pending_[i]++;
+                }
+                stripes_[i].shared = pending_[i] > 1;
+        }
+        done_.assign(stripes_.size(), false);
+        return queue;
+}
+
+/// a single byte given as itself, an escape (\n \t \r \0) or hex (0x2c)
+Maybe<char> UtilStripeBase::toByte(const std::string& d) const
+{
+        const std::unordered_map<std::string, char> escapes = {
+            { "\\n", '\n' },
+            { "\\t", '\t' },
+            { "\\r", '\r' },
+            { "\\0", '\0' },
+        };
+        if (const auto e = escapes.find(d); e != escapes.end())
+                return e->second;
+        if (d.size() == 1)
+                return d[0];
+        if (d.size() == 4 && d[0] == '0' && d[1] == 'x'
+            && std::isxdigit(static_cast<unsigned char>(d[2]))
+            && std::isxdigit(static_cast<unsigned char>(d[3])))
+                return static_cast<char>(std::stoi(d.substr(2), nullptr, 16));
+        return makeBad<char>("Bad delimiter " + d);
+}
+
+/// --records with no value splits on newlines
+Error UtilStripeBase::setRecords(const ArgMap& map)
+{
+        const auto records = argToIter(map, RECORDS_A);
+        if (!records)
+                return records.error();
+        const auto it = *records;
+        if (it == map.end())
+                return NONE;
+        records_ = true;
+        const auto ptr = it->second;
+        switch (ty::count(ptr)) {
+        case 0:
+                return NONE;
+        case 1: {
+                const auto delim = toByte(ptr->val_);
+                if (!delim)
+                        return delim.error();
+                delim_ = *delim;
+                return NONE;
+        }
+        default:
+                return "Too many delimiters";
+        }
+}
+
+void UtilStripeBase::describe(Manifest&) const
+{ }
+
+Error UtilStripeBase::checkPaths() const
+{
+        if (fs::is_directory(in_))
+                return "Cannot run on a directory";
+        for (const auto& dir : outs_)
+                if (!fs::exists(dir) || !fs::is_directory(dir))
+                        return "Bad output directory " + dir;
+        return NONE;
+}
+
+/// first count stripes of the set
+Manifest UtilStripeBase::manifest(const std::streamsize& fsize,
+    const size_t count) const
+{
+        Manifest m;
+        m.source = in_;
+        m.size = fsize;
+        m.dirs = store_.empty() ? outs_ : std::vector<std::string>{ store_ };
+        for (size_t i = 0; i < count; i++) {
+                const auto& st = stripes_[i];
+                const auto name = fs::path(st.path).filename().string();
+                m.entries.push_back({ i, st.offset, st.length, st.stored,
+                    st.dir, name });
+        }
+        if (compress_)
+                m.compress = compress_.str();
+        m.headers = header_;
+        m.store = !store_.empty();
+        describe(m);
+        return m;
+}
+
+Error UtilStripeBase::writeManifest(const std::streamsize& fsize) const
+{
+        const auto m = manifest(fsize, stripes_.size());
+        const bool durable = io_.sync != SyncMode::NONE;
+        for (const auto& dir : outs_)
+                if (const auto e = m.write(fs::path(dir)
+                    / Manifest::fileName(name_), durable))
+                        return e;
+        return NONE;
+}
+
+/// --index-only: the descriptor records where every stripe would start and
+/// who the source is, --Materialize copies a stripe out of it on demand
+Error UtilStripeBase::writeIndex(const FileDesc& file,
+    const std::streamsize& fsize)
+{
+        struct stat st;
+        if (::fstat(file.get(), &st) == -1)
+                return util::sysError("stat", in_);
+        const auto length = numberLength(stripes_.size() - 1);
+        for (size_t i = 0; i < stripes_.size(); i++) {
+                stripes_[i].dir = i % outs_.size();
+                stripes_[i].path = stripePath(i, length,
+                    outs_[stripes_[i].dir]);
+        }
+        auto m = manifest(fsize, stripes_.size());
+        m.source = fs::absolute(in_).string();
+        m.indexOnly = true;
+        m.inode = st.st_ino;
+        m.mtime = st.st_mtim.tv_sec * 1'000'000'000LL + st.st_mtim.tv_nsec;
+        const bool durable = io_.sync != SyncMode::NONE;
+        for (const auto& dir : outs_) {
+                const auto path = fs::path(dir) / Manifest::fileName(name_);
+                if (const auto e = m.write(path, durable))
+                        return e;
+                if (!silence_)
+                        Row::print(RIGHT, path, m.serialize().size());
+        }
+        return NONE;
+}
+
+bool UtilStripeBase::mine(const size_t stripe) const
+{
+        return !shards_ || stripe % shards_ == shard_;
+}
+
+Maybe<long long> UtilStripeBase::modified(const FileDesc& file) const
+{
+        struct stat st;
+        if (::fstat(file.get(), &st) == -1)
+                return makeBad<long long>(util::sysError("stat", in_));
+        return st.st_mtim.tv_sec * 1'000'000'000LL + st.st_mtim.tv_nsec;
+}
+
+/// Every participant of a --shard run has to put the same set id in its
+/// headers without talking to the others, so it is derived from what they
+/// all see: the size and mtime of the source and the plan. The path is
+/// left out since hosts may mount the share in different places.
+Maybe<StripeHeader::SetId> UtilStripeBase::sharedSet(const FileDesc& file,
+    const std::streamsize& fsize) const
+{
+        const auto mtime = modified(file);
+        if (!mtime)
+                return makeBad<StripeHeader::SetId>(mtime.error());
+        std::string seed = name_ + "\n" + std::to_string(fsize) + "\n"
+            + std::to_string(*mtime) + "\n";
+        for (const auto& st : stripes_)
+                seed += std::to_string(st.offset) + "\n";
+        Sha256 sha;
+        sha.update(seed.data(), seed.size());
+        const auto digest = sha.digest();
+        StripeHeader::SetId id;
+        std::copy_n(digest.begin(), id.size(), id.begin());
+        return id;
+}
+
+/// Records which stripes this participant wrote, only once they are
+/// durable. The mtime of the source tells a record of this run from one
+/// left behind by an earlier run over an older version of the file.
+Error UtilStripeBase::writeShard(const FileDesc& file,
+    const std::streamsize& fsize) const
+{
+        const auto mtime = modified(file);
+        if (!mtime)
+                return mtime.error();
+        auto m = manifest(fsize, stripes_.size());
+        m.entries.erase(std::remove_if(m.entries.begin(), m.entries.end(),
+            [this](const ManifestEntry& e) {
+                return !mine(e.index);
+        }), m.entries.end());
+        m.mtime = *mtime;
+        const bool durable = io_.sync != SyncMode::NONE;
+        for (const auto& dir : outs_)
+                if (const auto e = m.write(fs::path(dir)
+                    / Manifest::shardName(name_, shard_, shards_), durable))
+                        return e;
+        return NONE;
+}
+
+/// A record only counts when it holds exactly the stripes participant k
+/// plans for this source: anything else was left by an earlier run over
+/// another version of the file or with another stripe size.
+bool UtilStripeBase::current(const Manifest& rec, const size_t k,
+    const long long mtime, const std::streamsize& fsize) const
+{
+        if (rec.mtime != mtime || rec.size != fsize)
+                return false;
+        size_t want = 0;
+        for (size_t i = k; i < stripes_.size(); i += shards_)
+                want++;
+        if (rec.entries.size() != want)
+                return false;
+        for (const auto& e : rec.entries) {
+                if (e.index >= stripes_.size() || e.index % shards_ != k)
+                        return false;
+                const auto& st = stripes_[e.index];
+                if (e.offset != st.offset || e.length != st.length)
+                        return false;
+                if (store_.empty() && (e.dir != st.dir
+                    || e.name != fs::path(st.path).filename().string()))
+                        return false;
+        }
+        return true;
+}
+
+/// Completion check of a --shard run. Whichever participant finds every
+/// record in place merges them into the manifest of the whole set and
+/// removes them, the others leave it to whoever finishes last. Several may
+/// merge at once, they all write the same manifest. Records are found by
+/// listing the directory rather than looking each one up, NFS may answer a
+/// lookup from a cached miss while a listing revalidates the directory.
+Error UtilStripeBase::gather(const FileDesc& file,
+    const std::streamsize& fsize) const
+{
+        const auto mtime = modified(file);
+        if (!mtime)
+                return mtime.error();
+        std::unordered_map<std::string, size_t> names;
+        for (size_t k = 0; k < shards_; k++)
+                names[Manifest::shardName(name_, k, shards_)] = k;
+        std::vector<ManifestEntry> entries;
+        std::vector<bool> found(shards_, false);
+        std::error_code ec;
+        for (const auto& f : fs::directory_iterator(outs_.front(), ec)) {
+                const auto it = names.find(f.path().filename().string());
+                if (it == names.end() || found[it->second])
+                        continue;
+                /// unreadable is gone, taken by a participant that merged
+                auto rec = Manifest::read(f.path().string());
+                if (!rec || !current(*rec, it->second, *mtime, fsize))
+                        continue;
+                found[it->second] = true;
+                for (auto& e : rec->entries)
+                        entries.push_back(std::move(e));
+        }
+        if (ec)
+                return "Failed to list " + outs_.front() + " (" + ec.message()
+                    + ")";
+        const auto missing = std::count(found.begin(), found.end(), false);
+        if (missing) {
+                if (!silence_)
+                        std::cout << "Shard " << shard_ << "/" << shards_
+                                  << " done, waiting on " << missing
+                                  << " more\n";
+                return NONE;
+        }
+        std::sort(entries.begin(), entries.end(),
+            [](const ManifestEntry& a, const ManifestEntry& b) {
+                return a.index < b.index;
+        });
+        auto m = manifest(fsize, 0);
+        m.entries = std::move(entries);
+        const bool durable = io_.sync != SyncMode::NONE;
+        for (const auto& dir : outs_) {
+                const auto path = fs::path(dir) / Manifest::fileName(name_);
+                if (const auto e = m.write(path, durable))
+                        return e;
+                if (!silence_)
+                        Row::print(RIGHT, path, m.serialize().size());
+        }
+        for (const auto& dir : outs_)
+                for (const auto& [name, k] : names)
+                        fs::remove(fs::path(dir) / name, ec);
+        return NONE;
+}
+
+/// A set being sharded again must not look finished through the manifest
+/// of an earlier run. No participant merges before this one has recorded
+/// its stripes, so removing it here never loses the current one.
+Error UtilStripeBase::unpublish() const
+{
+        for (const auto& dir : outs_) {
+                std::error_code ec;
+                fs::remove(fs::path(dir) / Manifest::fileName(name_), ec);
+                if (ec)
+                        return "Failed to remove " + Manifest::fileName(name_)
+                            + " in " + dir + " (" + ec.message() + ")";
+        }
+        return NONE;
+}
+
+/// --bundle: stripes of a directory are laid back to back in one file,
+/// preallocated with room for the index so threads write in place
+Error UtilStripeBase::openBundles()
+{
+        filled_.assign(outs_.size(), 0);
+        std::vector<size_t> entries(outs_.size(), 0);
+        for (auto& st : stripes_) {
+                st.at = filled_[st.dir];
+                st.path = (fs::path(outs_[st.dir])
+                    / Bundle::fileName(name_)).string();
+                filled_[st.dir] += st.length;
+                entries[st.dir]++;
+        }
+        for (size_t d = 0; d < outs_.size(); d++) {
+                auto out = FileDesc::openWrite((fs::path(outs_[d])
+                    / Bundle::fileName(name_)).string());
+                if (!out)
+                        return out.error();
+                if (const auto e = out->allocate(filled_[d]
+                    + entries[d] * Bundle::ENTRY + Bundle::TRAILER,
+                    io_.sparse))
+                        return *e;
+                bundles_.push_back(out.extract());
+        }
+        return NONE;
+}
+
+/// index and trailer go after the data once every stripe is in
+Error UtilStripeBase::sealBundles(const std::streamsize& fsize,
+    Durability& dur)
+{
+        std::vector<Bundle> bundles(outs_.size());
+        for (size_t i = 0; i < stripes_.size(); i++) {
+                const auto& st = stripes_[i];
+                bundles[st.dir].entries.push_back({ i,
+                    static_cast<std::uint64_t>(st.offset),
+                    static_cast<std::uint64_t>(st.at),
+                    static_cast<std::uint64_t>(st.length), st.crc });
+        }
+        for (size_t d = 0; d < outs_.size(); d++) {
+                auto& b = bundles[d];
+                b.set = set_;
+                b.count = stripes_.size();
+                b.size = fsize;
+                if (const auto e = b.write(bundles_[d], filled_[d]))
+                        return e;
+                const auto path = bundles_[d].path();
+                if (const auto e = dur.settle(std::move(bundles_[d])))
+                        return e;
+                if (!silence_)
+                        Row::print(RIGHT, path, filled_[d] + b.indexSize());
+        }
+        return NONE;
+}
+
+bool UtilStripeBase::bundled(const FileDesc& file, IOBuffer& buffer,
+    const size_t stripe)
+{
+        auto& st = stripes_[stripe];
+        const auto bytes = transfer(file, st.offset, st.length,
+            bundles_[st.dir], st.at, buffer, nullptr, &st.crc);
+        if (!bytes) {
+                fail(bytes.error());
+                return false;
+        }
+        return true;
+}
+
+/// Marks a stripe finished and, when that extends the run of finished
+/// stripes from the front, republishes the ready manifest. Done under the
+/// lock so the published prefix only ever grows.
+Error UtilStripeBase::complete(const size_t stripe)
+{
+        std::lock_guard<std::mutex> lock(wmtx_);
+        done_[stripe] = true;
+        const auto before = ready_;
+        while (ready_ < done_.size() && done_[ready_])
+                ready_++;
+        if (ready_ == before)
+                return NONE;
+        const auto& last = stripes_.back();
+        const auto m = manifest(last.offset + last.length, ready_);
+        const bool durable = io_.sync != SyncMode::NONE;
+        for (const auto& dir : outs_)
+                if (const auto e = m.write(fs::path(dir)
+                    / Manifest::readyName(name_), durable))
+                        return e;
+        return NONE;
+}
+
+/// Stripes written by several threads cannot be truncated on open, so they
+/// are created and preallocated before any worker starts.
+Error UtilStripeBase::prepare()
+{
+        for (const auto& st : stripes_) {
+                if (!st.shared)
+                        continue;
+                const auto file = FileDesc::openWrite(st.path);
+                if (!file)
+                        return file.error();
+                if (const auto e = file->allocate(st.length, io_.sparse))
+                        return *e;
+        }
+        return NONE;
+}
+
+/// copies or compresses a range of the input, returns the bytes written
+Maybe<std::streamsize> UtilStripeBase::transfer(const FileDesc& file,
+    off_t offset, std::streamsize length, const FileDesc& out, off_t outOff,
+    IOBuffer& buffer, Codec* codec, std::uint32_t* crc, Sha256* sha)
+{
+        if (codec)
+                return codec->pack(file, offset, length, out, outOff, sha);
+        const auto bytes = buffer.chunk(file, offset, out, outOff, length, io_,
+            crc, sha);
+        if (!bytes)
+                return makeBad<std::streamsize>(bytes.error());
+        if (*bytes != length)
+                return makeBad<std::streamsize>("Input shrank: " + in_);
+        return length;
+}
+
+/// --store: the stripe is hashed first and named by that hash, so a stripe
+/// already stored costs one read and no write. A miss copies it to a
+/// temporary file, hashing again to catch an input that changed between
+/// the passes, and renames it into place so a reader never sees a partial
+/// object. Raw objects are named by the hash alone, packed ones carry the
+/// codec since their bytes differ.
+bool UtilStripeBase::deposit(const FileDesc& file, Durability& dur,
+    IOBuffer& buffer, Codec* codec, const size_t stripe)
+{
+        auto& st = stripes_[stripe];
+        Sha256 first;
+        const auto hashed = buffer.digest(file, st.offset, st.length, first);
+        if (!hashed || *hashed != st.length) {
+                fail(hashed ? "Input shrank: " + in_ : hashed.error());
+                return false;
+        }
+        const auto hex = first.hex();
+        const auto object = (fs::path(store_) / (codec ? hex + "."
+            + compress_.str().substr(0, compress_.str().find(':'))
+            : hex)).string();
+        st.path = object;
+        std::error_code ec;
+        if (const auto size = fs::file_size(object, ec); !ec) {
+                if (!codec && static_cast<std::streamsize>(size) != st.length) {
+                        fail("Stored stripe size mismatch: " + object);
+                        return false;
+                }
+                st.stored = codec ? size : 0;
                 if (!silence_) {
                         std::lock_guard<std::mutex> lock(mtx_);
-                        Row::print(RIGHT, path, bytes);
+                        Row::print(SAME, object, size);
+                }
+                return true;
+        }
+        /// a packed stripe is not known to shrink, so room for the raw one
+        if (const auto e = util::checkSpace(store_, st.length)) {
+                fail(*e);
+                return false;
+        }
+        const auto tmp = (fs::path(store_) / (std::to_string(::getpid())
+            + "." + std::to_string(stripe) + ".tmp")).string();
+        auto out = FileDesc::openWrite(tmp);
+        if (!out) {
+                fail(out.error());
+                return false;
+        }
+        if (!codec) {
+                if (const auto e = out->allocate(st.length, io_.sparse)) {
+                        fail(*e);
+                        return false;
+                }
+        }
+        Sha256 second;
+        const auto bytes = transfer(file, st.offset, st.length, *out, 0,
+            buffer, codec, nullptr, &second);
+        if (!bytes) {
+                fail(bytes.error());
+                return false;
+        }
+        if (second.hex() != hex) {
+                ::unlink(tmp.c_str());
+                fail("Input changed while storing: " + in_);
+                return false;
+        }
+        st.stored = codec ? *bytes : 0;
+        /// a hit trusts whatever has the name, it must be whole first
+        if (io_.sync != SyncMode::NONE) {
+                if (const auto e = out->sync()) {
+                        fail(*e);
+                        return false;
                 }
         }
+        if (std::rename(tmp.c_str(), object.c_str()) == -1) {
+                fail(util::sysError("Failed to rename", tmp));
+                return false;
+        }
+        if (const auto e = dur.settle(out.extract())) {
+                fail(*e);
+                return false;
+        }
+        if (!silence_) {
+                std::lock_guard<std::mutex> lock(mtx_);
+                Row::print(RIGHT, object, *bytes);
+        }
+        return true;
+}
+
+bool UtilStripeBase::copy(const FileDesc& file, Durability& dur,
+    IOBuffer& buffer, Codec* codec, const Piece& piece)
+{
+        if (bundle_)
+                return bundled(file, buffer, piece.stripe);
+        if (!store_.empty()) {
+                if (!deposit(file, dur, buffer, codec, piece.stripe))
+                        return false;
+                if (ordered_)
+                        if (const auto e = complete(piece.stripe)) {
+                                fail(*e);
+                                return false;
+                        }
+                return true;
+        }
+        auto& st = stripes_[piece.stripe];
+        auto outFile = st.shared ? FileDesc::openUpdate(st.path)
+                                 : FileDesc::openWrite(st.path);
+        if (!outFile) {
+                fail(outFile.error());
+                return false;
+        }
+        const off_t skip = header_ ? StripeHeader::SIZE : 0;
+        if (!st.shared && !codec) {
+                if (const auto e = outFile->allocate(skip + st.length,
+                    io_.sparse)) {
+                        fail(*e);
+                        return false;
+                }
+        }
+        std::uint32_t crc = 0;
+        const auto bytes = transfer(file, st.offset + piece.offset,
+            piece.length, *outFile, skip + piece.offset, buffer, codec,
+            header_ ? &crc : nullptr);
+        if (!bytes) {
+                fail(bytes.error());
+                return false;
+        }
+        /// written last, a stripe cut short has no valid header
+        if (header_) {
+                const StripeHeader h = { set_, piece.stripe, stripes_.size(),
+                    static_cast<std::uint64_t>(st.offset),
+                    static_cast<std::uint64_t>(st.length), crc };
+                const auto raw = h.encode();
+                if (const auto e = outFile->writeAt(raw.data(), raw.size(),
+                    0)) {
+                        fail(*e);
+                        return false;
+                }
+        }
+        if (codec)
+                st.stored = *bytes;
+        /// the last piece of a stripe settles it, fsync covers every fd
+        if (--pending_[piece.stripe] > 0)
+                return true;
+        if (const auto e = dur.settle(outFile.extract())) {
+                fail(*e);
+                return false;
+        }
+        if (!silence_) {
+                std::lock_guard<std::mutex> lock(mtx_);
+                Row::print(RIGHT, st.path, codec ? st.stored : st.length);
+        }
+        if (ordered_) {
+                if (const auto e = complete(piece.stripe)) {
+                        fail(*e);
+                        return false;
+                }
+        }
+        return true;
+}
+
+void UtilStripeBase::worker(const FileDesc& file, Durability& dur,
+    const std::vector<Piece>& pieces)
+{
+        IOBuffer buffer;
+        for (const auto& piece : pieces)
+                if (failure_ || !copy(file, dur, buffer, nullptr, piece))
+                        return;
+}
+
+void UtilStripeBase::drain(const FileDesc& file, Durability& dur,
+    const std::vector<Piece>& queue)
+{
+        auto codec = Codec::create(compress_);
+        if (!codec) {
+                fail(codec.error());
+                return;
+        }
+        IOBuffer buffer;
+        for (size_t i; (i = next_++) < queue.size(); )
+                if (failure_ || !copy(file, dur, buffer, codec->get(),
+                    queue[i]))
+                        return;
+}
+
+/// Writes the next stripe of a --follow run, each one is written once and
+/// left alone afterwards.
+Error UtilStripeBase::emit(const FileDesc& file, Durability& dur,
+    IOBuffer& buffer, Codec* codec, const off_t offset,
+    const std::streamsize length)
+{
+        constexpr size_t width = 6;
+        const auto i = stripes_.size();
+        if (numberLength(i) > width)
+                return "Too many stripes to follow";
+        size_t dir = i % outs_.size();
+        if (placement_ == Placement::CAPACITY) {
+                std::uintmax_t most = 0;
+                for (size_t d = 0; d < outs_.size(); d++) {
+                        const auto space = util::freeSpace(outs_[d]);
+                        if (!space)
+                                return space.error();
+                        if (*space > most) {
+                                most = *space;
+                                dir = d;
+                        }
+                }
+        }
+        const auto path = stripePath(i, width, outs_[dir]);
+        if (const auto e = util::checkSpace(outs_[dir], length))
+                return *e;
+        auto out = FileDesc::openWrite(path);
+        if (!out)
+                return out.error();
+        if (!codec)
+                if (const auto e = out->allocate(length, io_.sparse))
+                        return *e;
+        const auto bytes = transfer(file, offset, length, *out, 0, buffer,
+            codec);
+        if (!bytes)
+                return bytes.error();
+        if (const auto e = dur.settle(out.extract()))
+                return *e;
+        stripes_.push_back({ offset, length, path, dir, false,
+            codec ? *bytes : 0 });
+        if (!silence_)
+                Row::print(RIGHT, path, *bytes);
+        if (!ordered_)
+                return NONE;
+        done_.push_back(false);
+        return complete(i);
+}
+
+/// Stripes a file that is still being appended to. Every full stripe is
+/// written as soon as the input has grown past its end, the tail once the
+/// writer closes the file, it is moved or deleted, or nothing happened for
+/// idle_ seconds. Names have a fixed width since the count is not known.
+Error UtilStripeBase::follow(const FileDesc& file)
+{
+        const std::streamsize stripeSize = getStripeSize(0);
+        if (stripeSize < 4'000)
+                return "Stripe size too small";
+        if (records_)
+                return "Follow does not split on records";
+        if (!store_.empty())
+                return "Follow does not write to a store";
+        auto watcher = Watcher::open();
+        if (!watcher)
+                return watcher.error();
+        if (const auto e = watcher->add(in_, IN_MODIFY | IN_CLOSE_WRITE
+            | IN_MOVE_SELF | IN_DELETE_SELF))
+                return *e;
+        auto codec = Codec::create(compress_);
+        if (!codec)
+                return codec.error();
+        Durability dur(io_.sync);
+        IOBuffer buffer;
+        stripes_.clear();
+        off_t at = 0;
+        for (bool open = true; ; ) {
+                const auto size = file.size();
+                if (!size)
+                        return size.error();
+                for (; *size - at >= stripeSize; at += stripeSize)
+                        if (const auto e = emit(file, dur, buffer,
+                            codec->get(), at, stripeSize))
+                                return *e;
+                if (!open)
+                        break;
+                const auto events = watcher->next(idle_ * 1'000);
+                if (!events)
+                        return events.error();
+                open = !events->empty();
+                for (const auto& ev : *events)
+                        if (ev.mask & (IN_CLOSE_WRITE | IN_MOVE_SELF
+                            | IN_DELETE_SELF | IN_IGNORED))
+                                open = false;
+        }
+        const auto size = file.size();
+        if (!size)
+                return size.error();
+        if (*size > at)
+                if (const auto e = emit(file, dur, buffer, codec->get(), at,
+                    *size - at))
+                        return *e;
+        if (stripes_.empty())
+                return "Empty file?";
+        if (manifest_ || outs_.size() > 1 || compress_)
+                if (const auto e = writeManifest(*size))
+                        return *e;
+        if (const auto e = dur.finish(outs_))
+                return *e;
+        if (!silence_ && io_.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
 }
 
 Error UtilStripeBase::run()
 {
         if (!silence_)
                 std::cout << util::BANNER << "\nStriping\n";
-        if (fs::is_directory(in_))
-                return "Cannot run on a directory";
-        if (!fs::exists(out_) || !fs::is_directory(out_))
-                return "Bad output directory";
-        std::ifstream file(in_, std::ios::binary);
+        BufferPool::instance().configure(io_);
+        if (const auto e = checkPaths())
+                return *e;
+        const auto file = FileDesc::openRead(in_);
         if (!file)
-                return "Invalid File";
-        const auto fsize = util::fileSize(file);
-        if (fsize == -1)
+                return file.error();
+        if (follow_)
+                return follow(*file);
+        const auto size = file->size();
+        if (!size)
+                return size.error();
+        const auto fsize = *size;
+        if (fsize == 0)
                 return "Empty file?";
-        const auto stripeSize = getStripeSize(fsize);
-        if (stripeSize < 4'000)
-                return "Stripe size too small";
-        const auto stripes = getStripes(fsize, stripeSize);
-        const auto length = numberLength(stripes - 1);
-        const auto starts = fileIndex(stripes);
-        auto descriptors = files(starts, stripeSize);
-        if (!descriptors)
-                return descriptors.error();
+        auto planned = plan(*file, fsize);
+        if (!planned)
+                return planned.error();
+        stripes_ = planned.extract();
+        if (indexOnly_)
+                return writeIndex(*file, fsize);
+        if (store_.empty())
+                if (const auto e = place())
+                        return *e;
+        pending_ = std::vector<std::atomic<int>>(stripes_.size());
+        if (header_ && shards_) {
+                auto set = sharedSet(*file, fsize);
+                if (!set)
+                        return set.error();
+                set_ = *set;
+        } else if (header_ || bundle_) {
+                set_ = StripeHeader::newSet();
+        }
+        if (bundle_)
+                if (const auto e = openBundles())
+                        return *e;
+        /// a checksum is taken in one pass over the stripe
+        const bool whole = compress_ || !store_.empty() || header_ || bundle_;
+        const bool queued = ordered_ || whole;
+        const auto work = queued ? std::vector<std::vector<Piece>>()
+                                 : groups();
+        const auto queue = queued ? ordered(!whole) : std::vector<Piece>();
+        if (shards_)
+                if (const auto e = unpublish())
+                        return *e;
+        if (const auto e = prepare())
+                return *e;
+        Durability dur(io_.sync);
         std::vector<std::thread> threads;
-        const int t = std::min(threadc_, static_cast<int>(starts.size()) - 1);
-        for (int i = 0; i < t; i++) {
-                auto& f = (*descriptors)[i];
-                const auto& start = starts[i];
-                const auto& end = starts[i + 1];
+        for (int t = 0; queued && t < std::max(1, threadc_); t++) {
+                threads.emplace_back(
+                    &UtilStripeBase::drain,
+                    this,
+                    std::cref(*file),
+                    std::ref(dur),
+                    std::cref(queue));
+        }
+        for (const auto& pieces : work) {
                 threads.emplace_back(
                     &UtilStripeBase::worker,
                     this,
-                    std::ref(f),
-                    WD{ start, end, length, stripeSize });
+                    std::cref(*file),
+                    std::ref(dur),
+                    std::cref(pieces));
         }
         for (auto& t : threads)
                 t.join();
         if (failure_)
                 return fmsg_;
-        return NONE;
+        if (bundle_)
+                if (const auto e = sealBundles(fsize, dur))
+                        return *e;
+        if (!bundle_ && !shards_ && (manifest_ || outs_.size() > 1
+            || compress_ || !store_.empty()))
+                if (const auto e = writeManifest(fsize))
+                        return *e;
+        auto dirs = outs_;
+        if (!store_.empty())
+                dirs.push_back(store_);
+        if (const auto e = dur.finish(dirs))
+                return *e;
+        if (!silence_ && io_.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        if (!shards_)
+                return NONE;
+        if (const auto e = writeShard(*file, fsize))
+                return *e;
+        return gather(*file, fsize);
 }
 
 Error UtilStripeBase::setFlags(const ArgMap& map)
 {
+        if (const auto e = setIOFlags(map))
+                return *e;
         if (const auto m = validFlag(map, NO_PAD_F); m && *m)
                 padding_ = false;
         else if (!m)
@@ -181,35 +1071,104 @@ Error UtilStripeBase::setFlags(const ArgMap& map)
                 useExt_ = false;
         else if (!m)
                 return m.error();
+        if (const auto m = validFlag(map, MANIFEST_F); m && *m)
+                manifest_ = true;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, ORDERED_F); m && *m)
+                ordered_ = true;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, FOLLOW_F); m && *m)
+                follow_ = true;
+        else if (!m)
+                return m.error();
+        /// the stripe count is unknown while following, so names always pad
+        if (follow_ && !padding_)
+                return "Follow pads stripe numbers, drop --no-padding";
+        if (const auto m = validFlag(map, INDEX_F); m && *m)
+                indexOnly_ = true;
+        else if (!m)
+                return m.error();
+        if (const auto m = validFlag(map, HEADER_F); m && *m)
+                header_ = true;
+        else if (!m)
+                return m.error();
+        if (indexOnly_ && (follow_ || compress_ || !store_.empty()))
+                return "Index only writes no stripe data";
+        if (const auto m = validFlag(map, BUNDLE_F); m && *m)
+                bundle_ = true;
+        else if (!m)
+                return m.error();
+        if (header_ && (follow_ || compress_ || !store_.empty() || indexOnly_))
+                return "Headers are only written on plain stripes";
+        if (bundle_ && (follow_ || compress_ || !store_.empty() || indexOnly_
+            || header_ || ordered_))
+                return "Bundles hold plain stripes";
+        if (shards_ && (follow_ || ordered_ || indexOnly_ || bundle_))
+                return "Shard only splits a plain stripe run";
         return NONE;
 }
 
 Error UtilStripeBase::setArgs(const ArgMap& map)
 {
-        if (const auto e = UtilBaseSingle::setArgs(map))
+        if (const auto e = setPath(map, IN_A, in_))
+                return *e;
+        if (const auto e = setPaths(map, OUT_A, outs_))
+                return *e;
+        out_ = outs_.front();
+        if (const auto e = setIOArgs(map))
                 return *e;
         if (const auto e = setMember(map, NAME_A, name_))
                 return *e;
         if (const auto e = setMember(map, EXT_A, ext_))
                 return *e;
-        const auto threads = argToIter(map, THREADS_A);
-        if (!threads)
-                return threads.error();
-        if (const auto it = *threads; it != map.end()) {
-                const auto ptr = it->second;
-                switch (ty::count(ptr)) {
-                case 0:
-                        return "No threads";
-                case 1: {
-                        const auto t = std::stoi(ptr->val_);
-                        if (t == 0)
-                                return "Can't have zero threads";
-                        threadc_ = t;
-                        break;
-                }
-                default:
-                        return "Too many threads";
-                }
+        if (const auto e = setThreads(map, threadc_))
+                return *e;
+        if (const auto e = setRecords(map))
+                return *e;
+        std::string placement;
+        if (const auto e = setMember(map, PLACE_A, placement))
+                return *e;
+        if (placement == "capacity")
+                placement_ = Placement::CAPACITY;
+        else if (!placement.empty() && placement != "round-robin")
+                return "Bad placement " + placement;
+        if (const auto e = setShard(map, shard_, shards_))
+                return *e;
+        /// free space differs between hosts, every one must place alike
+        if (shards_ && placement_ == Placement::CAPACITY)
+                return "Shard needs round-robin placement";
+        std::string compress;
+        if (const auto e = setMember(map, COMPRESS_A, compress))
+                return *e;
+        if (!compress.empty()) {
+                const auto c = Compression::parse(compress);
+                if (!c)
+                        return c.error();
+                if (const auto codec = Codec::create(*c); !codec)
+                        return codec.error();
+                compress_ = *c;
         }
+        if (const auto e = setMember(map, STORE_A, store_))
+                return *e;
+        if (!store_.empty()) {
+                store_ = toPath(store_);
+                std::error_code ec;
+                fs::create_directories(store_, ec);
+                if (ec)
+                        return "Bad store " + store_ + " (" + ec.message()
+                            + ")";
+        }
+        std::string idle;
+        if (const auto e = setMember(map, IDLE_A, idle))
+                return *e;
+        if (idle.size() >= 10
+            || !std::all_of(idle.begin(), idle.end(), util::isDigit))
+                return "Bad idle " + idle;
+        if (!idle.empty())
+                idle_ = std::stoi(idle);
+        if (!idle_)
+                return "Idle needs at least a second";
         return NONE;
 }
@@ -17,25 +17,63 @@
 #ifndef UTIL_STRIPE_BASE_HH
 #define UTIL_STRIPE_BASE_HH
 
-#include "Maybe.hh"
+#include "src/Maybe.hh"
 #include "src/types.hh"
 #include "src/UtilBaseSingle.hh"
 #include "src/IOBuffer.hh"
+#include "src/FileDesc.hh"
+#include "src/Durability.hh"
 #include "src/Failure.hh"
-#include <fstream>
+#include "src/Manifest.hh"
+#include "src/Codec.hh"
+#include "src/StripeHeader.hh"
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <vector>
 
-struct WD {
-        int start;
-        int end;
-        size_t len;
-        size_t size;
+/// one output file and the input range it holds
+struct Stripe {
+        off_t offset;
+        std::streamsize length;
+        std::string path;
+        size_t dir = 0;
+        bool shared = false; /// split between threads, created upfront
+        std::streamsize stored = 0; /// bytes on disk when compressed
+        off_t at = 0; /// position in its --bundle
+        std::uint32_t crc = 0; /// of the data, kept for --bundle
 };
 
+/// part of a stripe copied by a single thread
+struct Piece {
+        size_t stripe;
+        off_t offset; /// within the stripe
+        std::streamsize length;
+};
+
+enum class Placement { ROUND_ROBIN, CAPACITY };
+
 class UtilStripeBase : public UtilBaseSingle
                      , protected Failure {
 protected:
+        std::vector<std::string> outs_;
+        Placement placement_ = Placement::ROUND_ROBIN;
+        bool manifest_ = false;
+        bool ordered_ = false;
+        bool follow_ = false;
+        bool indexOnly_ = false;
+        bool header_ = false;
+        bool bundle_ = false;
+        size_t shard_ = 0; /// --shard k/N, this run copies stripes i % N == k
+        size_t shards_ = 0; /// 0 when not sharded
+        StripeHeader::SetId set_{}; /// shared by the headers of this run
+        std::vector<FileDesc> bundles_; /// one per output directory
+        std::vector<off_t> filled_; /// data bytes in each bundle
+        Compression compress_;
+        std::string store_; /// content addressed, outs_ only get the recipe
+        int idle_ = 10; /// seconds without growth that end --follow
+        bool records_ = false;
+        char delim_ = '\n';
         std::string name_ = "";
         std::string ext_ = "stripe";
         bool padding_ = true;
@@ -44,16 +82,67 @@ protected:
         std::mutex mtx_; /// std::cout
         size_t getStripes(const std::streamsize& size, const size_t& stripeSize)
             const;
-        std::string fileName(const int& number, const size_t& len) const;
         size_t numberLength(const size_t& rem) const;
         std::string stripePath(const size_t& num, const size_t& max,
             const std::string& out) const;
         virtual size_t getStripeSize(const size_t& fsize) const = 0;
         Conflict conflicting() const override;
-        std::vector<int> fileIndex(const size_t& stripes) const;
-        Maybe<IFiles> files(const std::vector<int>& indexs, const size_t& s)
+        std::vector<Stripe> stripes_;
+        std::vector<std::atomic<int>> pending_;
+        std::atomic<size_t> next_ = 0; /// --ordered queue position
+        std::mutex wmtx_; /// watermark
+        std::vector<bool> done_;
+        size_t ready_ = 0; /// stripes finished without a gap
+        std::vector<Stripe> fromCuts(const std::vector<off_t>& cuts,
+            const std::streamsize& fsize) const;
+        Maybe<off_t> nextRecord(const FileDesc& file, off_t from,
+            const std::streamsize& fsize) const;
+        virtual Maybe<std::vector<Stripe>> plan(const FileDesc& file,
+            const std::streamsize& fsize) const;
+        Maybe<char> toByte(const std::string& d) const;
+        Error setRecords(const ArgMap& map);
+        Error place();
+        std::vector<std::vector<Piece>> schedule(
+            const std::vector<size_t>& members, const int threads);
+        std::vector<std::vector<Piece>> groups();
+        std::vector<Piece> ordered(const bool split);
+        Manifest manifest(const std::streamsize& fsize, const size_t count)
+            const;
+        Error writeManifest(const std::streamsize& fsize) const;
+        Error writeIndex(const FileDesc& file, const std::streamsize& fsize);
+        bool mine(const size_t stripe) const;
+        Maybe<StripeHeader::SetId> sharedSet(const FileDesc& file,
+            const std::streamsize& fsize) const;
+        Maybe<long long> modified(const FileDesc& file) const;
+        Error writeShard(const FileDesc& file, const std::streamsize& fsize)
             const;
-        void worker(std::ifstream& file, const WD& data);
+        bool current(const Manifest& rec, const size_t k,
+            const long long mtime, const std::streamsize& fsize) const;
+        Error gather(const FileDesc& file, const std::streamsize& fsize) const;
+        Error unpublish() const;
+        Error openBundles();
+        Error sealBundles(const std::streamsize& fsize, Durability& dur);
+        bool bundled(const FileDesc& file, IOBuffer& buffer,
+            const size_t stripe);
+        Error complete(const size_t stripe);
+        Error follow(const FileDesc& file);
+        Error emit(const FileDesc& file, Durability& dur, IOBuffer& buffer,
+            Codec* codec, const off_t offset, const std::streamsize length);
+        Maybe<std::streamsize> transfer(const FileDesc& file, off_t offset,
+            std::streamsize length, const FileDesc& out, off_t outOff,
+            IOBuffer& buffer, Codec* codec, std::uint32_t* crc = nullptr,
+            Sha256* sha = nullptr);
+        virtual void describe(Manifest& m) const;
+        Error checkPaths() const;
+        Error prepare();
+        void worker(const FileDesc& file, Durability& dur,
+            const std::vector<Piece>& pieces);
+        void drain(const FileDesc& file, Durability& dur,
+            const std::vector<Piece>& queue);
+        bool copy(const FileDesc& file, Durability& dur, IOBuffer& buffer,
+            Codec* codec, const Piece& piece);
+        bool deposit(const FileDesc& file, Durability& dur, IOBuffer& buffer,
+            Codec* codec, const size_t stripe);
 public:
         UtilStripeBase() = default;
         virtual ~UtilStripeBase() = default;
@@ -21,15 +21,32 @@
 std::unordered_set<std::string> UtilStripeFixed::validArgs() const
 {
         return {
-            "--input"       , "-i" ,
-            "--output"      , "-o" ,
-            "--name"        , "-n" ,
-            "--extension"   , "-e" ,
-            "--no-padding"  , "-np",
-            "--quiet"       , "-q" ,
-            "--no-extension", "-ne",
-            "--parts"       , "-p" ,
-            "--threads"     , "-t" ,
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--records"        , "-r" ,
+            "--name"           , "-n" ,
+            "--extension"      , "-e" ,
+            "--no-padding"     , "-np",
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--parts"          , "-p" ,
+            "--threads"        , "-t" ,
+            "--placement"      , "-pl",
+            "--manifest"       , "-m" ,
+            "--compress"       , "-z" ,
+            "--store"          , "-st",
+            "--index-only"     , "-io",
+            "--header"         , "-hd",
+            "--bundle"         , "-bd",
+            "--shard"          , "-sh",
+            "--ordered"        , "-or",
+            "--streaming-cache", "-sc",
+            "--cache-window"   , "-cw",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sparse"         , "-sp",
+            "--sync"           , "-sy",
         };
 }
 
@@ -0,0 +1,313 @@
+/**
+ * File: UtilStripeHash.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/UtilStripeHash.hh"
+#include "src/BufferPool.hh"
+#include "src/Durability.hh"
+#include "src/Row.hh"
+#include "src/scan.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+std::unordered_set<std::string> UtilStripeHash::validArgs() const
+{
+        return {
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--hash"           , "-hs",
+            "--key"            , "-k" ,
+            "--field-separator", "-fs",
+            "--records"        , "-r" ,
+            "--name"           , "-n" ,
+            "--extension"      , "-e" ,
+            "--no-padding"     , "-np",
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--threads"        , "-t" ,
+            "--placement"      , "-pl",
+            "--sync"           , "-sy",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+        };
+}
+
+size_t UtilStripeHash::getStripeSize(const size_t& fsize) const
+{
+        return fsize / parts_ + 1;
+}
+
+/// a field number, or from:length for a byte range of the record
+Error UtilStripeHash::setKey(const std::string& key)
+{
+        const auto colon = key.find(':');
+        const auto number = [](const std::string& s) -> Maybe<size_t> {
+                if (s.empty() || s.size() >= 10
+                    || !std::all_of(s.begin(), s.end(), util::isDigit))
+                        return makeBad<size_t>("Bad key " + s);
+                return std::stoull(s);
+        };
+        if (colon == std::string::npos) {
+                const auto field = number(key);
+                if (!field)
+                        return field.error();
+                if (!*field)
+                        return "Fields start at 1";
+                field_ = *field;
+                return NONE;
+        }
+        const auto from = number(key.substr(0, colon));
+        const auto length = number(key.substr(colon + 1));
+        if (!from)
+                return from.error();
+        if (!length)
+                return length.error();
+        if (!*length)
+                return "Empty key";
+        from_ = *from;
+        length_ = *length;
+        return NONE;
+}
+
+Error UtilStripeHash::setArgs(const ArgMap& map)
+{
+        if (const auto e = UtilStripeBase::setArgs(map))
+                return *e;
+        std::string parts;
+        if (const auto e = setMember(map, HASH_A, parts))
+                return *e;
+        if (parts.empty() || parts.size() >= 10
+            || !std::all_of(parts.begin(), parts.end(), util::isDigit))
+                return "Bad hash " + parts;
+        parts_ = std::stoull(parts);
+        if (!parts_)
+                return "Can't have zero partitions";
+        std::string key;
+        if (const auto e = setMember(map, KEY_A, key))
+                return *e;
+        if (!key.empty())
+                if (const auto e = setKey(key))
+                        return *e;
+        std::string sep;
+        if (const auto e = setMember(map, SEP_A, sep))
+                return *e;
+        if (!sep.empty()) {
+                const auto byte = toByte(sep);
+                if (!byte)
+                        return byte.error();
+                sep_ = *byte;
+        }
+        return NONE;
+}
+
+/// key of a record without its delimiter, a missing field is empty
+std::string_view UtilStripeHash::key(const char* p, const size_t n) const
+{
+        if (!field_) {
+                if (from_ >= n)
+                        return {};
+                return { p + from_, std::min(length_, n - from_) };
+        }
+        size_t at = 0;
+        for (size_t f = 1; f < field_; f++) {
+                const auto hit = scan::find(p + at, n - at, sep_);
+                if (hit == n - at)
+                        return {};
+                at += hit + 1;
+        }
+        return { p + at, scan::find(p + at, n - at, sep_) };
+}
+
+/// FNV-1a, stable between runs and machines unlike std::hash
+size_t UtilStripeHash::partition(const char* p, const size_t n) const
+{
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (const auto c : key(p, n)) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 0x100000001b3ULL;
+        }
+        return h % parts_;
+}
+
+/// Records of [from, to) are appended to per partition batches held in pool
+/// buffers, a full batch reserves its place in the partition with one atomic
+/// add and is written positionally, so no lock is taken per record. A
+/// record still open at the end is left in carry.
+void UtilStripeHash::reader(const FileDesc& file, off_t from, off_t to,
+    std::string& carry)
+{
+        auto& pool = BufferPool::instance();
+        const auto batch = pool.size();
+        std::vector<BufferPool::Lease> batches;
+        std::vector<size_t> fill(parts_, 0);
+        for (size_t k = 0; k < parts_; k++) {
+                batches.push_back(pool.checkout());
+                if (!batches.back()) {
+                        fail("Failed to map i/o buffer");
+                        return;
+                }
+        }
+        const auto flush = [&](const size_t k, const char* p, const size_t n) {
+                if (!n)
+                        return true;
+                const auto at = ends_[k].fetch_add(n);
+                if (const auto e = outputs_[k].writeAt(p, n, at)) {
+                        fail(*e);
+                        return false;
+                }
+                return true;
+        };
+        const auto emit = [&](const char* p, const size_t n) {
+                const auto k = partition(p, n - 1);
+                if (fill[k] + n > batch) {
+                        if (!flush(k, batches[k].data(), fill[k]))
+                                return false;
+                        fill[k] = 0;
+                }
+                if (n > batch)
+                        return flush(k, p, n);
+                std::copy(p, p + n, batches[k].data() + fill[k]);
+                fill[k] += n;
+                return true;
+        };
+        auto buffer = pool.checkout();
+        if (!buffer) {
+                fail("Failed to map i/o buffer");
+                return;
+        }
+        carry.clear(); /// record split across two reads
+        for (off_t at = from; at < to && !failure_; ) {
+                const auto use = std::min<off_t>(buffer.size(), to - at);
+                const auto read = file.readAt(buffer.data(), use, at);
+                if (!read) {
+                        fail(read.error());
+                        return;
+                }
+                if (!*read) {
+                        fail("Input shrank: " + in_);
+                        return;
+                }
+                const auto n = static_cast<size_t>(*read);
+                const char* p = buffer.data();
+                size_t i = 0;
+                while (i < n) {
+                        const auto hit = scan::find(p + i, n - i, delim_);
+                        if (hit == n - i) {
+                                carry.append(p + i, n - i);
+                                break;
+                        }
+                        const auto len = hit + 1;
+                        if (!carry.empty()) {
+                                carry.append(p + i, len);
+                                if (!emit(carry.data(), carry.size()))
+                                        return;
+                                carry.clear();
+                        } else if (!emit(p + i, len)) {
+                                return;
+                        }
+                        i += len;
+                }
+                at += *read;
+        }
+        for (size_t k = 0; k < parts_; k++)
+                if (!flush(k, batches[k].data(), fill[k]))
+                        return;
+}
+
+Error UtilStripeHash::run()
+{
+        if (!silence_)
+                std::cout << util::BANNER << "\nPartitioning\n";
+        BufferPool::instance().configure(io_);
+        if (const auto e = checkPaths())
+                return *e;
+        const auto file = FileDesc::openRead(in_);
+        if (!file)
+                return file.error();
+        const auto size = file->size();
+        if (!size)
+                return size.error();
+        const auto fsize = *size;
+        if (fsize == 0)
+                return "Empty file?";
+        /// partition sizes are only known afterwards, place on an even split
+        stripes_.assign(parts_, { 0, static_cast<std::streamsize>(
+            getStripeSize(fsize)), "" });
+        if (const auto e = place())
+                return *e;
+        outputs_.clear();
+        for (const auto& st : stripes_) {
+                auto out = FileDesc::openWrite(st.path);
+                if (!out)
+                        return out.error();
+                outputs_.push_back(out.extract());
+        }
+        ends_ = std::vector<std::atomic<off_t>>(parts_);
+        /// each reader holds a batch per partition and its read buffer
+        const auto cap = BufferPool::instance().capacity();
+        if (cap && cap < parts_ + 1)
+                return "Max memory too small for " + std::to_string(parts_)
+                    + " partitions";
+        if (cap)
+                threadc_ = static_cast<int>(std::min<size_t>(threadc_,
+                    cap / (parts_ + 1)));
+        std::vector<off_t> cuts = { 0 };
+        const off_t share = fsize / threadc_ + 1;
+        for (int t = 1; t < threadc_; t++) {
+                const auto next = nextRecord(*file,
+                    std::max<off_t>(t * share - 1, cuts.back()), fsize);
+                if (!next)
+                        return next.error();
+                if (*next > cuts.back() && *next < fsize)
+                        cuts.push_back(*next);
+        }
+        cuts.push_back(fsize);
+        std::vector<std::thread> threads;
+        std::vector<std::string> carries(cuts.size() - 1);
+        for (size_t t = 0; t + 1 < cuts.size(); t++)
+                threads.emplace_back(&UtilStripeHash::reader, this,
+                    std::cref(*file), cuts[t], cuts[t + 1],
+                    std::ref(carries[t]));
+        for (auto& t : threads)
+                t.join();
+        if (failure_)
+                return fmsg_;
+        /// only the end of the file can hold an unterminated record, it is
+        /// written after every batch so nothing follows it in its partition
+        if (const auto& tail = carries.back(); !tail.empty()) {
+                const auto k = partition(tail.data(), tail.size());
+                if (const auto e = outputs_[k].writeAt(tail.data(),
+                    tail.size(), ends_[k]))
+                        return *e;
+                ends_[k] += tail.size();
+        }
+        Durability dur(io_.sync);
+        for (size_t k = 0; k < parts_; k++) {
+                stripes_[k].length = ends_[k];
+                if (const auto e = dur.settle(std::move(outputs_[k])))
+                        return *e;
+                if (!silence_)
+                        Row::print(RIGHT, stripes_[k].path, stripes_[k].length);
+        }
+        if (const auto e = dur.finish(outs_))
+                return *e;
+        if (!silence_ && io_.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
+}
@@ -0,0 +1,48 @@
+/**
+ * File: UtilStripeHash.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef UTIL_STRIPE_HASH_HH
+#define UTIL_STRIPE_HASH_HH
+
+#include "src/UtilStripeBase.hh"
+#include <string_view>
+
+/// Records are shuffled into N partition files by the hash of a key.
+class UtilStripeHash final : public UtilStripeBase {
+private:
+        size_t parts_ = 0;
+        size_t field_ = 0; /// 1 based, 0 keys on a byte range
+        size_t from_ = 0;
+        size_t length_ = std::string::npos;
+        char sep_ = '\t';
+        std::vector<FileDesc> outputs_;
+        std::vector<std::atomic<off_t>> ends_;
+        std::unordered_set<std::string> validArgs() const override;
+        size_t getStripeSize(const size_t& fsize) const override;
+        Error setKey(const std::string& key);
+        std::string_view key(const char* p, const size_t n) const;
+        size_t partition(const char* p, const size_t n) const;
+        void reader(const FileDesc& file, off_t from, off_t to,
+            std::string& carry);
+public:
+        UtilStripeHash() = default;
+        virtual ~UtilStripeHash() = default;
+        UtilStripeHash(const UtilStripeHash&) = delete;
+        Error run() override;
+        Error setArgs(const ArgMap& map) override;
+};
+
+#endif /// UTIL_STRIPE_HASH_HH
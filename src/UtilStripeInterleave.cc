@@ -0,0 +1,134 @@
+/**
+ * File: UtilStripeInterleave.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/UtilStripeInterleave.hh"
+#include "src/Interleave.hh"
+#include "src/BufferPool.hh"
+#include "src/Durability.hh"
+#include "src/Row.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include <algorithm>
+#include <iostream>
+
+std::unordered_set<std::string> UtilStripeInterleave::validArgs() const
+{
+        return {
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--name"           , "-n" ,
+            "--extension"      , "-e" ,
+            "--no-padding"     , "-np",
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--interleave"     , "-il",
+            "--unit"           , "-u" ,
+            "--threads"        , "-t" ,
+            "--placement"      , "-pl",
+            "--manifest"       , "-m" ,
+            "--sync"           , "-sy",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+        };
+}
+
+size_t UtilStripeInterleave::getStripeSize(const size_t&) const
+{
+        return unit_;
+}
+
+void UtilStripeInterleave::describe(Manifest& m) const
+{
+        m.interleave = files_;
+        m.unit = unit_;
+}
+
+Error UtilStripeInterleave::setArgs(const ArgMap& map)
+{
+        if (const auto e = UtilStripeBase::setArgs(map))
+                return *e;
+        std::string files;
+        if (const auto e = setMember(map, INTERLEAVE_A, files))
+                return *e;
+        if (files.empty() || files.size() >= 10
+            || !std::all_of(files.begin(), files.end(), util::isDigit))
+                return "Bad interleave " + files;
+        files_ = std::stoull(files);
+        if (files_ < 2)
+                return "Interleave needs at least two files";
+        if (const auto e = setBytes(map, UNIT_A, unit_))
+                return *e;
+        if (unit_ < 512)
+                return "Unit too small";
+        return NONE;
+}
+
+/// Every window of the input is read once and written to all files with one
+/// vectored write each. The window buffer covers a whole row of blocks
+/// unless the user asked for a larger one.
+Error UtilStripeInterleave::run()
+{
+        constexpr size_t maxWindow = 1'024 * 1'024 * 64;
+        if (!silence_)
+                std::cout << util::BANNER << "\nStriping\n";
+        io_.bufferSize = std::max({ io_.bufferSize, unit_,
+            std::min(maxWindow, files_ * unit_) });
+        BufferPool::instance().configure(io_);
+        if (const auto e = checkPaths())
+                return *e;
+        const auto file = FileDesc::openRead(in_);
+        if (!file)
+                return file.error();
+        const auto size = file->size();
+        if (!size)
+                return size.error();
+        const auto fsize = *size;
+        if (fsize == 0)
+                return "Empty file?";
+        const Interleave layout(files_, unit_, fsize);
+        stripes_.clear();
+        for (size_t k = 0; k < files_; k++)
+                stripes_.push_back({ static_cast<off_t>(k * unit_),
+                    layout.fileSize(k), "" });
+        if (const auto e = place())
+                return *e;
+        std::vector<FileDesc> outputs;
+        for (const auto& st : stripes_) {
+                auto out = FileDesc::openWrite(st.path);
+                if (!out)
+                        return out.error();
+                if (const auto e = out->allocate(st.length))
+                        return *e;
+                outputs.push_back(out.extract());
+        }
+        if (const auto e = layout.split(*file, outputs, threadc_))
+                return *e;
+        Durability dur(io_.sync);
+        for (size_t k = 0; k < files_; k++) {
+                if (const auto e = dur.settle(std::move(outputs[k])))
+                        return *e;
+                if (!silence_)
+                        Row::print(RIGHT, stripes_[k].path, stripes_[k].length);
+        }
+        if (const auto e = writeManifest(fsize))
+                return *e;
+        if (const auto e = dur.finish(outs_))
+                return *e;
+        if (!silence_ && io_.sync != SyncMode::NONE)
+                Row::timing("sync", dur.millis());
+        return NONE;
+}
@@ -0,0 +1,37 @@
+/**
+ * File: UtilStripeInterleave.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef UTIL_STRIPE_INTERLEAVE_HH
+#define UTIL_STRIPE_INTERLEAVE_HH
+
+#include "src/UtilStripeBase.hh"
+
+class UtilStripeInterleave final : public UtilStripeBase {
+private:
+        size_t files_ = 0;
+        size_t unit_ = 1'024 * 1'024;
+        std::unordered_set<std::string> validArgs() const override;
+        size_t getStripeSize(const size_t& fsize) const override;
+        void describe(Manifest& m) const override;
+public:
+        UtilStripeInterleave() = default;
+        virtual ~UtilStripeInterleave() = default;
+        UtilStripeInterleave(const UtilStripeInterleave&) = delete;
+        Error run() override;
+        Error setArgs(const ArgMap& map) override;
+};
+
+#endif /// UTIL_STRIPE_INTERLEAVE_HH
@@ -0,0 +1,172 @@
+/**
+ * File: UtilStripeLines.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/UtilStripeLines.hh"
+#include "src/BufferPool.hh"
+#include "src/scan.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include <algorithm>
+#include <thread>
+
+std::unordered_set<std::string> UtilStripeLines::validArgs() const
+{
+        return {
+            "--input"          , "-i" ,
+            "--output"         , "-o" ,
+            "--lines"          , "-l" ,
+            "--records"        , "-r" ,
+            "--name"           , "-n" ,
+            "--extension"      , "-e" ,
+            "--no-padding"     , "-np",
+            "--quiet"          , "-q" ,
+            "--no-extension"   , "-ne",
+            "--threads"        , "-t" ,
+            "--placement"      , "-pl",
+            "--manifest"       , "-m" ,
+            "--compress"       , "-z" ,
+            "--store"          , "-st",
+            "--index-only"     , "-io",
+            "--header"         , "-hd",
+            "--bundle"         , "-bd",
+            "--shard"          , "-sh",
+            "--ordered"        , "-or",
+            "--streaming-cache", "-sc",
+            "--cache-window"   , "-cw",
+            "--buffer-size"    , "-bs",
+            "--max-memory"     , "-mm",
+            "--huge-pages"     , "-hp",
+            "--sparse"         , "-sp",
+            "--sync"           , "-sy",
+        };
+}
+
+size_t UtilStripeLines::getStripeSize(const size_t& fsize) const
+{
+        return fsize;
+}
+
+Error UtilStripeLines::setArgs(const ArgMap& map)
+{
+        if (const auto e = UtilStripeBase::setArgs(map))
+                return *e;
+        std::string lines;
+        if (const auto e = setMember(map, LINES_A, lines))
+                return *e;
+        if (lines.empty() || lines.size() >= 10
+            || !std::all_of(lines.begin(), lines.end(), util::isDigit))
+                return "Bad lines " + lines;
+        lines_ = std::stoull(lines);
+        if (!lines_)
+                return "Can't have zero lines";
+        return NONE;
+}
+
+namespace {
+
+/// Input range indexed by one thread. The first pass counts delimiters, the
+/// second, knowing how many came before, records where stripes start.
+struct Range {
+        off_t from;
+        off_t to;
+        size_t count = 0;
+        std::vector<off_t> cuts;
+        Error error;
+};
+
+/// runs fn over every buffer sized block of the range
+template <typename F>
+Error blocks(const FileDesc& file, const Range& r, F fn)
+{
+        auto buffer = BufferPool::instance().checkout();
+        if (!buffer)
+                return "Failed to map i/o buffer";
+        for (off_t at = r.from; at < r.to; ) {
+                const auto use = std::min<off_t>(buffer.size(), r.to - at);
+                const auto read = file.readAt(buffer.data(), use, at);
+                if (!read)
+                        return read.error();
+                if (!*read)
+                        return "Unexpected end of file: " + file.path();
+                fn(buffer.data(), static_cast<size_t>(*read), at);
+                at += *read;
+        }
+        return NONE;
+}
+
+} /// namespace
+
+/// Two parallel passes over the input: count delimiters per thread range,
+/// then with the prefix sums each thread knows the ordinal of its first
+/// record and emits a cut after every lines_-th delimiter.
+Maybe<std::vector<Stripe>> UtilStripeLines::plan(const FileDesc& file,
+    const std::streamsize& fsize) const
+{
+        const off_t align = 1'024 * 1'024;
+        const off_t threads = std::clamp<off_t>(fsize / align, 1, threadc_);
+        const off_t share = (fsize / threads + align - 1) / align * align;
+        std::vector<Range> ranges;
+        for (off_t from = 0; from < fsize; from += share)
+                ranges.push_back({ from, std::min<off_t>(from + share, fsize),
+                    0, {}, NONE });
+        const auto parallel = [&](auto fn) {
+                std::vector<std::thread> pool;
+                for (auto& r : ranges)
+                        pool.emplace_back([&fn, &r] { fn(r); });
+                for (auto& t : pool)
+                        t.join();
+                for (const auto& r : ranges)
+                        if (r.error)
+                                return r.error;
+                return Error(NONE);
+        };
+        const auto e = parallel([&](Range& r) {
+                r.error = blocks(file, r, [&](const char* p, size_t n, off_t) {
+                        r.count += scan::count(p, n, delim_);
+                });
+        });
+        if (e)
+                return makeBad<std::vector<Stripe>>(*e);
+        size_t before = 0;
+        for (auto& r : ranges) {
+                const auto count = r.count;
+                r.count = before;
+                before += count;
+        }
+        const auto cuts = parallel([&](Range& r) {
+                auto seen = r.count;
+                r.error = blocks(file, r, [&](const char* p, size_t n,
+                    off_t at) {
+                        for (size_t i = 0; i < n; ) {
+                                const auto hit = scan::find(p + i, n - i,
+                                    delim_);
+                                if (hit == n - i)
+                                        break;
+                                i += hit + 1;
+                                if (++seen % lines_ == 0)
+                                        r.cuts.push_back(at + i);
+                        }
+                });
+        });
+        if (cuts)
+                return makeBad<std::vector<Stripe>>(*cuts);
+        std::vector<off_t> all = { 0 };
+        for (const auto& r : ranges)
+                for (const auto c : r.cuts)
+                        if (c < fsize)
+                                all.push_back(c);
+        return fromCuts(all, fsize);
+}
@@ -0,0 +1,37 @@
+/**
+ * File: UtilStripeLines.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef UTIL_STRIPE_LINES_HH
+#define UTIL_STRIPE_LINES_HH
+
+#include "src/UtilStripeBase.hh"
+
+/// Stripes hold a fixed number of records rather than bytes.
+class UtilStripeLines final : public UtilStripeBase {
+private:
+        size_t lines_ = 0;
+        std::unordered_set<std::string> validArgs() const override;
+        size_t getStripeSize(const size_t& fsize) const override;
+        Maybe<std::vector<Stripe>> plan(const FileDesc& file,
+            const std::streamsize& fsize) const override;
+public:
+        UtilStripeLines() = default;
+        virtual ~UtilStripeLines() = default;
+        UtilStripeLines(const UtilStripeLines&) = delete;
+        Error setArgs(const ArgMap& map) override;
+};
+
+#endif /// UTIL_STRIPE_LINES_HH
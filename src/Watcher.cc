@@ -0,0 +1,82 @@
+/**
+ * File: Watcher.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/Watcher.hh"
+#include "src/utils.hh"
+#include "src/consts.hh"
+#include <cerrno>
+#include <climits>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+Watcher::Watcher(FileDesc&& fd)
+    : fd_(std::move(fd))
+{ }
+
+Maybe<Watcher> Watcher::open()
+{
+        const auto fd = ::inotify_init1(IN_CLOEXEC);
+        if (fd == -1)
+                return makeBad<Watcher>(util::sysError("inotify", "init"));
+        return Watcher(FileDesc(fd, "inotify"));
+}
+
+Error Watcher::add(const std::string& path, const std::uint32_t mask)
+{
+        const auto wd = ::inotify_add_watch(fd_.get(), path.c_str(), mask);
+        if (wd == -1)
+                return util::sysError("Failed to watch", path);
+        paths_[wd] = path;
+        return NONE;
+}
+
+/// waits up to timeoutMs (-1 forever) and returns every queued event,
+/// nothing on timeout
+Maybe<std::vector<WatchEvent>> Watcher::next(const int timeoutMs) const
+{
+        std::vector<WatchEvent> events;
+        pollfd p = { fd_.get(), POLLIN, 0 };
+        const auto ready = ::poll(&p, 1, timeoutMs);
+        if (ready == -1 && errno == EINTR)
+                return events;
+        if (ready == -1)
+                return makeBad<std::vector<WatchEvent>>(
+                    util::sysError("poll", "inotify"));
+        if (!ready)
+                return events;
+        alignas(inotify_event) char buf[4'096 + sizeof(inotify_event)
+            + NAME_MAX + 1];
+        const auto r = ::read(fd_.get(), buf, sizeof(buf));
+        if (r == -1 && (errno == EINTR || errno == EAGAIN))
+                return events;
+        if (r == -1)
+                return makeBad<std::vector<WatchEvent>>(
+                    util::sysError("Read failed", "inotify"));
+        for (ssize_t at = 0; at < r; ) {
+                const auto* ev = reinterpret_cast<const inotify_event*>(
+                    buf + at);
+                at += sizeof(inotify_event) + ev->len;
+                const auto it = paths_.find(ev->wd);
+                if (it == paths_.end())
+                        continue;
+                auto path = it->second;
+                if (ev->len)
+                        path += "/" + std::string(ev->name);
+                events.push_back({ path, ev->mask });
+        }
+        return events;
+}
@@ -0,0 +1,49 @@
+/**
+ * File: Watcher.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef WATCHER_HH
+#define WATCHER_HH
+
+#include "src/FileDesc.hh"
+#include "src/Maybe.hh"
+#include "src/types.hh"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct WatchEvent {
+        std::string path; /// watched path, joined with the name for dirs
+        std::uint32_t mask;
+};
+
+/// inotify instance over a set of files or directories.
+class Watcher {
+private:
+        FileDesc fd_;
+        std::unordered_map<int, std::string> paths_; /// by watch descriptor
+        explicit Watcher(FileDesc&& fd);
+public:
+        Watcher() = default;
+        Watcher(Watcher&&) = default;
+        Watcher& operator=(Watcher&&) = default;
+        Watcher(const Watcher&) = delete;
+        static Maybe<Watcher> open();
+        Error add(const std::string& path, const std::uint32_t mask);
+        Maybe<std::vector<WatchEvent>> next(const int timeoutMs) const;
+};
+
+#endif /// WATCHER_HH
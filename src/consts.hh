@@ -21,6 +21,8 @@
 
 inline const auto NONE = std::nullopt;
 
+inline const std::string STDOUT_PATH = "-"; /// -o - streams to stdout
+
 inline const ArgT EXT_A = { "--extension", "-e", "extension" };
 
 inline const ArgT NAME_A = { "--name", "-n", "name" };
@@ -35,6 +37,52 @@ inline const ArgT PARTS_A = { "--parts", "-p", "parts" };
 
 inline const ArgT THREADS_A = { "--threads", "-t", "threads" };
 
+inline const ArgT WINDOW_A = { "--cache-window", "-cw", "cache window" };
+
+inline const ArgT SYNC_A = { "--sync", "-sy", "sync" };
+
+inline const ArgT BUFFER_A = { "--buffer-size", "-bs", "buffer size" };
+
+inline const ArgT MEMORY_A = { "--max-memory", "-mm", "max memory" };
+
+inline const ArgT PLACE_A = { "--placement", "-pl", "placement" };
+
+inline const ArgT INTERLEAVE_A = { "--interleave", "-il", "interleave" };
+
+inline const ArgT UNIT_A = { "--unit", "-u", "unit" };
+
+inline const ArgT RECORDS_A = { "--records", "-r", "records" };
+
+inline const ArgT LINES_A = { "--lines", "-l", "lines" };
+
+inline const ArgT HASH_A = { "--hash", "-hs", "hash" };
+
+inline const ArgT KEY_A = { "--key", "-k", "key" };
+
+inline const ArgT SEP_A = { "--field-separator", "-fs", "field separator" };
+
+inline const ArgT COMPRESS_A = { "--compress", "-z", "compress" };
+
+inline const ArgT STORE_A = { "--store", "-st", "store" };
+
+inline const ArgT IDLE_A = { "--idle", "-id", "idle" };
+
+inline const ArgT OFFSET_A = { "--offset", "-of", "offset" };
+
+inline const ArgT LENGTH_A = { "--length", "-ln", "length" };
+
+inline const ArgT STRIPE_A = { "--stripe", "-k", "stripe" };
+
+inline const ArgT OUT_NAME_A = { "--out-name", "-on", "out name" };
+
+inline const ArgT OUT_EXT_A = { "--out-extension", "-oe", "out extension" };
+
+inline const ArgT COUNT_A = { "--count", "-c", "count" };
+
+inline const ArgT SHARD_A = { "--shard", "-sh", "shard" };
+
+inline const ArgT SET_A = { "--set", "-ss", "set" };
+
 inline const ArgOr QUIET_F = { "--quiet", "-q" };
 
 inline const ArgOr NO_EXT_F = { "--no-extension", "-ne" };
@@ -43,4 +91,26 @@ inline const ArgOr NO_NAME_F = { "--no-name", "-nn" };
 
 inline const ArgOr NO_PAD_F = { "--no-padding", "-np" };
 
+inline const ArgOr STREAM_F = { "--streaming-cache", "-sc" };
+
+inline const ArgOr HUGE_F = { "--huge-pages", "-hp" };
+
+inline const ArgOr ORDERED_F = { "--ordered", "-or" };
+
+inline const ArgOr FOLLOW_F = { "--follow", "-f" };
+
+inline const ArgOr HEADER_F = { "--header", "-hd" };
+
+inline const ArgOr BUNDLE_F = { "--bundle", "-bd" };
+
+inline const ArgOr SPARSE_F = { "--sparse", "-sp" };
+
+inline const ArgOr IN_PLACE_F = { "--in-place", "-ip" };
+
+inline const ArgOr INDEX_F = { "--index-only", "-io" };
+
+inline const ArgOr WATCH_F = { "--watch", "-w" };
+
+inline const ArgOr MANIFEST_F = { "--manifest", "-m" };
+
 #endif /// CONSTS_HH
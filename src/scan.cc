@@ -0,0 +1,175 @@
+/**
+ * File: scan.cc
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#include "src/scan.hh"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace scan {
+
+namespace {
+
+size_t findScalar(const char* p, const size_t n, const char c)
+{
+        const auto hit = std::memchr(p, c, n);
+        return hit ? static_cast<const char*>(hit) - p : n;
+}
+
+size_t countScalar(const char* p, const size_t n, const char c)
+{
+        size_t acc = 0;
+        for (size_t i = 0; i < n; i++)
+                acc += p[i] == c;
+        return acc;
+}
+
+bool zeroScalar(const char* p, const size_t n)
+{
+        for (size_t i = 0; i < n; i++)
+                if (p[i])
+                        return false;
+        return true;
+}
+
+#ifdef SCAN_X86
+
+size_t findSse2(const char* p, const size_t n, const char c)
+{
+        const auto needle = _mm_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+                const auto v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(p + i));
+                const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+                if (mask)
+                        return i + __builtin_ctz(mask);
+        }
+        return i + findScalar(p + i, n - i, c);
+}
+
+size_t countSse2(const char* p, const size_t n, const char c)
+{
+        const auto needle = _mm_set1_epi8(c);
+        size_t acc = 0;
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+                const auto v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(p + i));
+                const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+                acc += __builtin_popcount(mask);
+        }
+        return acc + countScalar(p + i, n - i, c);
+}
+
+bool zeroSse2(const char* p, const size_t n)
+{
+        size_t i = 0;
+        auto acc = _mm_setzero_si128();
+        for (; i + 16 <= n; i += 16)
+                acc = _mm_or_si128(acc, _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(p + i)));
+        const auto eq = _mm_cmpeq_epi8(acc, _mm_setzero_si128());
+        if (_mm_movemask_epi8(eq) != 0xffff)
+                return false;
+        return zeroScalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+size_t findAvx2(const char* p, const size_t n, const char c)
+{
+        const auto needle = _mm256_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+                const auto v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(p + i));
+                const unsigned mask = _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(v, needle));
+                if (mask)
+                        return i + __builtin_ctz(mask);
+        }
+        return i + findSse2(p + i, n - i, c);
+}
+
+__attribute__((target("avx2")))
+size_t countAvx2(const char* p, const size_t n, const char c)
+{
+        const auto needle = _mm256_set1_epi8(c);
+        size_t acc = 0;
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+                const auto v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(p + i));
+                const unsigned mask = _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(v, needle));
+                acc += __builtin_popcount(mask);
+        }
+        return acc + countSse2(p + i, n - i, c);
+}
+
+__attribute__((target("avx2")))
+bool zeroAvx2(const char* p, const size_t n)
+{
+        size_t i = 0;
+        auto acc = _mm256_setzero_si256();
+        for (; i + 32 <= n; i += 32)
+                acc = _mm256_or_si256(acc, _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(p + i)));
+        if (!_mm256_testz_si256(acc, acc))
+                return false;
+        return zeroSse2(p + i, n - i);
+}
+
+const bool AVX2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+}();
+
+#endif
+
+} /// namespace
+
+size_t find(const char* p, const size_t n, const char c)
+{
+#ifdef SCAN_X86
+        return AVX2 ? findAvx2(p, n, c) : findSse2(p, n, c);
+#else
+        return findScalar(p, n, c);
+#endif
+}
+
+size_t count(const char* p, const size_t n, const char c)
+{
+#ifdef SCAN_X86
+        return AVX2 ? countAvx2(p, n, c) : countSse2(p, n, c);
+#else
+        return countScalar(p, n, c);
+#endif
+}
+
+bool zero(const char* p, const size_t n)
+{
+#ifdef SCAN_X86
+        return AVX2 ? zeroAvx2(p, n) : zeroSse2(p, n);
+#else
+        return zeroScalar(p, n);
+#endif
+}
+
+} /// scan
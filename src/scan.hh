@@ -0,0 +1,35 @@
+/**
+ * File: scan.hh
+ * Copyright (C) 2025 Tyler Triplett
+ * License: GNU GPL 3.0 or later <https://www.gnu.org/licenses/gpl-3.0.html>
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SCAN_HH
+#define SCAN_HH
+
+#include <cstddef>
+
+/// Byte scans over i/o buffers, AVX2 when the cpu has it, SSE2 otherwise.
+namespace scan {
+
+/// offset of the first c in [p, p + n) or n
+size_t find(const char* p, const size_t n, const char c);
+
+size_t count(const char* p, const size_t n, const char c);
+
+/// true when [p, p + n) holds only zero bytes
+bool zero(const char* p, const size_t n);
+
+} /// scan
+
+#endif /// SCAN_HH
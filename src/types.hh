@@ -39,6 +39,4 @@ using FilesL = ty::List<std::string>;
 
 using Conflict = std::vector<std::tuple<ArgOr, ArgOr, std::string>>;
 
-using IFiles = std::vector<std::ifstream>;
-
 #endif /// TYPES_HH
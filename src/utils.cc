@@ -15,6 +15,16 @@
  */
 
 #include "src/utils.hh"
+#include "src/consts.hh"
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <filesystem>
+#include <sys/statvfs.h>
+
+namespace fs = std::filesystem;
 
 namespace util {
 
@@ -70,12 +80,91 @@ bool isAlpha(const char c)
         return std::isalpha(uc);
 }
 
-std::streamsize fileSize(std::ifstream& file)
+Maybe<size_t> stringToBytes(const std::string& size)
+{
+        auto it = size.begin();
+        while (it != size.end() && (isDigit(*it) || *it == '.'))
+                it++;
+        const std::string num(size.begin(), it);
+        const auto d = std::count_if(num.begin(), num.end(), [](const auto c) {
+                return c == '.';
+        });
+        if (num.empty() || num == "." || num.size() > 20 || d > 1
+            || (it != size.end() && !isAlpha(*it)))
+                return makeBad<size_t>("Bad byte size");
+        const std::unordered_map<std::string, size_t> map = {
+            { "b" , 1 },
+            { "kb", 1'000 },
+            { "mb", 1'000'000 },
+            { "gb", 1'000'000'000 },
+            { "kib", 1ul << 10 },
+            { "mib", 1ul << 20 },
+            { "gib", 1ul << 30 },
+        };
+        const auto suffix = mapv<std::string>(it, size.end(), [](const auto c) {
+                return std::tolower(c);
+        });
+        const auto itr = map.find(suffix);
+        const auto found = itr != map.end();
+        if (!suffix.empty() && !found)
+                return makeBad<size_t>("Bad suffix: " + suffix);
+        const size_t units = found ? itr->second : 1;
+        const double dbytes = std::stod(num) * units;
+        /// anything used as a file offset has to fit off_t
+        if (dbytes >= static_cast<double>(std::numeric_limits<off_t>::max()))
+                return makeBad<size_t>("Byte size too large: " + size);
+        return static_cast<size_t>(dbytes);
+}
+
+Maybe<std::uintmax_t> freeSpace(const std::string& dir)
+{
+        struct statvfs st;
+        if (::statvfs(dir.c_str(), &st) == -1)
+                return makeBad<std::uintmax_t>(sysError("statvfs", dir));
+        return static_cast<std::uintmax_t>(st.f_bavail) * st.f_frsize;
+}
+
+Error checkSpace(const std::string& dir, const std::uintmax_t need)
+{
+        const auto avail = freeSpace(dir);
+        if (!avail)
+                return avail.error();
+        if (*avail < need)
+                return "Not enough space in " + dir + ": need "
+                    + std::to_string(need) + " bytes, have "
+                    + std::to_string(*avail) + " bytes";
+        return NONE;
+}
+
+std::string stripePath(const std::string& out, const std::string& name,
+    const size_t num, const size_t width, const bool padding,
+    const std::string& ext)
+{
+        auto n = std::to_string(num);
+        if (padding && n.size() < width)
+                n.insert(0, width - n.size(), '0');
+        const auto base = name + (name.empty() ? "" : "_") + n;
+        return fs::path(out) / (ext.empty() ? base : base + "." + ext);
+}
+
+std::string sysError(const std::string& what, const std::string& path)
+{
+        const auto err = errno;
+        return what + ": " + path + " (" + std::strerror(err) + ")";
+}
+
+void putLE(char* p, std::uint64_t v, const int bytes)
+{
+        for (int i = 0; i < bytes; i++, v >>= 8)
+                p[i] = static_cast<char>(v & 0xff);
+}
+
+std::uint64_t getLE(const char* p, const int bytes)
 {
-        file.seekg(0, std::ios::end);
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        return size;
+        std::uint64_t v = 0;
+        for (int i = bytes - 1; i >= 0; i--)
+                v = v << 8 | static_cast<unsigned char>(p[i]);
+        return v;
 }
 
 } /// util
@@ -18,8 +18,10 @@
 #define UTILS_HH
 
 #include "src/types.hh"
+#include "src/Maybe.hh"
 #include <string>
-#include <fstream>
+#include <ios>
+#include <cstdint>
 
 namespace util {
 
@@ -44,7 +46,25 @@ bool isDigit(const char c);
 
 bool isAlpha(const char c);
 
-std::streamsize fileSize(std::ifstream& file);
+/// bytes or number followed by suffix (kb, mb, gb, kib, mib, gib)
+Maybe<size_t> stringToBytes(const std::string& size);
+
+Maybe<std::uintmax_t> freeSpace(const std::string& dir);
+
+Error checkSpace(const std::string& dir, const std::uintmax_t need);
+
+/// out/NAME_NUM.EXT, NUM zero padded to width digits, no dot for an empty ext
+std::string stripePath(const std::string& out, const std::string& name,
+    const size_t num, const size_t width, const bool padding,
+    const std::string& ext);
+
+/// "what path: strerror(errno)"
+std::string sysError(const std::string& what, const std::string& path);
+
+/// little endian fields of the binary stripe headers and bundle indexes
+void putLE(char* p, std::uint64_t v, const int bytes);
+
+std::uint64_t getLE(const char* p, const int bytes);
 
 inline const std::string BANNER =
 R"( _______| |__  _ __ __ _
@@ -52,6 +72,45 @@ R"( _______| |__  _ __ __ _
  / /  __/ |_) | | | (_| |
 /___\___|_.__/|_|  \__,_|)";
 
+/// i/o options and flags shared by -S and both forms of -A
+inline const std::string IO_HELP =
+R"(    -cw, --cache-window <window size>
+        Bytes copied between write-behind calls with --streaming-cache,
+            default 8mib
+        Example:
+            -cw 16mb
+    -sy, --sync <none|end|each|batch>
+        Durability of the written data, default none. The time spent is
+            printed separately.
+            end   : one syncfs and directory fsync once everything is written
+            each  : fsync every file as it completes
+            batch : fsync completed files on a background thread, then end
+        Example:
+            --sync batch
+    -bs, --buffer-size <buffer size>
+        Size of each i/o buffer, default 64kib
+        Example:
+            -bs 8mib
+    -mm, --max-memory <max memory>
+        Budget for all i/o buffers together. Threads wait for a free buffer
+            once it is spent.
+        Example:
+            -mm 256mib
+)";
+
+inline const std::string IO_FLAGS_HELP =
+R"(    -sc, --streaming-cache <streaming cache>
+        Stream data past the page cache: sequential readahead, write-behind
+            every cache window and dropping pages once they are on disk.
+    -hp, --huge-pages <huge pages>
+        Back i/o buffers with explicit huge pages when available, otherwise
+            transparent huge pages.
+    -sp, --sparse <sparse>
+        Keep holes: ranges the filesystem reports as holes are skipped
+            unread and blocks of zeros are not written, outputs are sized
+            upfront instead of preallocated.
+)";
+
 inline const std::string HELP =
 R"(Usage: zebra [mode option] [required option] [required option]
 [optional option] ... [optional flags] ...
@@ -64,7 +123,12 @@ Modes:
     Stripes file into pieces
 Required :
     -i, --input <input file>
-    -o, --output <ouput directory>
+    -o, --output <ouput directory> ...
+        Several directories stripe across all of them, each directory gets
+            its own group of threads. A manifest recording where every
+            stripe went is written to each directory.
+        Example:
+            -o /mnt/nvme0 /mnt/nvme1 /mnt/nvme2
 Optional :
    OR:
         -s, --size  <stripe size>
@@ -78,6 +142,44 @@ Optional :
             Number of parts a file is striped into
             Example:
                 -p 10
+        -il, --interleave <number of files>
+            RAID-0 style interleaving, block i of the unit size goes to file
+                i mod N. A manifest is always written, assembly reads it to
+                de-interleave. --streaming-cache does not apply.
+            Example:
+                -il 8
+            -u, --unit <unit size>
+                Block size used with --interleave, default 1mib
+                Example:
+                    -u 256kib
+        -l, --lines <lines per stripe>
+            Every stripe holds exactly N records, the last one the rest.
+                Records end at the --records delimiter, newline by default.
+            Example:
+                -l 1000000
+        -hs, --hash <partitions>
+            Records are shuffled into N partition files by the hash of their
+                key, several threads read record aligned ranges of the input.
+                Order within a partition is not kept.
+            Example:
+                -hs 64
+            -k, --key <field | from:length>
+                Key field counted from 1, or a byte range of the record,
+                default the whole record
+                Example:
+                    -k 2
+                    -k 0:8
+            -fs, --field-separator <separator>
+                Separates --key fields, default tab, same forms as --records
+                Example:
+                    -fs ,
+    -r, --records [delimiter]
+        Stripe boundaries are moved forward to just past the next delimiter
+            so no record is split. Default newline, a single character,
+            an escape (\n \t \r \0) or a hex byte.
+        Example:
+            -r
+            -r 0x1e
     -n, --name <name suffix>
         Part name suffix. Parts will be named `NAME SUFFIX`_`NUMBER`.stripe
         Example:
@@ -88,11 +190,62 @@ Optional :
             -e part | 001.part
             -e txt  | 001.txt
     -t, --threads <threads>
-        The amount of threads the program will try to use.
+        The amount of threads the program will try to use. The input is
+            divided between threads by bytes, large stripes are copied by
+            several threads at once.
         Example:
             -t 4
             --threads 4
-Flag(s)
+    -pl, --placement <round-robin|capacity>
+        How stripes are spread over several output directories, default
+            round-robin. capacity favours the directory with the most
+            free space left.
+        Example:
+            -pl capacity
+    -or, --ordered
+        Threads take stripes front to back from one queue instead of each
+            owning a range, and <name>.ready, a manifest of the stripes
+            finished without a gap, is replaced every time that run grows.
+    -z, --compress <zstd|lz4|zlib[:level]>
+        Compress every stripe on its own, whole stripes are handed to
+            threads. A manifest with both sizes is always written and
+            assembly expands stripes in parallel. Codecs are compiled in
+            when their library is found at build time. Levels go up to 22
+            for zstd, 12 for lz4 (lz4hc) and 9 for zlib, 0 is the default.
+        Example:
+            -z zstd
+            -z lz4:9
+    -st, --store <store directory>
+        Content addressed output. Stripes are named by their SHA-256 in the
+            store. Each is hashed before anything is written, one already
+            there costs a read only, a new one is read again to copy it
+            once the store has room for it. The output directories only get
+            the recipe, a manifest pointing into the store, which -A
+            assembles from as usual.
+        Example:
+            -st /backup/store
+    -io, --index-only
+        Write only the manifest: the source path, its inode, mtime and size
+            and where every stripe would start. No stripe data is copied,
+            -M cuts a stripe out of the source once it is needed.
+    -f, --follow
+        Stripe a file that is still being written, only with --size. Each
+            stripe is written once the input has grown past its end and the
+            rest once the writer closes the file or it stops growing.
+            Stripe numbers are always padded to six digits.
+        -id, --idle <seconds>
+            Time without growth that ends --follow, default 10
+            Example:
+                -id 60
+    -sh, --shard <k/N>
+        Write only stripes i with i % N == k, so N hosts sharing the
+            output directories stripe one file together, named as a single
+            run would. Each records its stripes in `NAME`.shard-k-of-N and
+            the last one to finish merges them into `NAME`.manifest and
+            removes them. Records of another plan or source are ignored.
+        Example:
+            -sh 0/4
+)" + IO_HELP + R"(Flag(s)
     -np, --no-padding <no padding>
         This will cause stripes to not have padding on their numbers.
         Example:
@@ -102,13 +255,33 @@ Flag(s)
         This will silence normal outputs, warnings will still print.
     -ne, --no-extension <no extension>
         No extension will be added.
-
+    -m, --manifest <manifest>
+        Write `NAME`.manifest (zebra.manifest without a name) recording the
+            offset, length and directory of every stripe.
+    -hd, --header <header>
+        Start every stripe with a 64 byte header: an id shared by the run,
+            the stripe's index, the stripe count, its offset and length and
+            a CRC-32 of its data. -A --header places stripes by it alone.
+    -bd, --bundle <bundle>
+        Write the stripes of each output directory into one `NAME`.bundle
+            (zebra.bundle without a name) instead of a file each. A trailing
+            index holds every stripe's offset, length and CRC-32, -A and -E
+            read the bundles in their input directories straight from it.
+)" + IO_FLAGS_HELP + R"(
 -A, --Assemble <Assemble>
     Assemble, assembles pieces back to a single file
 Required (1) :
 Note: Assembles all ".stripe" files in directory in lexicographical order:
-    -i, --intput  <input directory>
+Note: A manifest in an input directory is used instead when present
+    -i, --intput  <input directory> ...
+        Several directories are searched together, stripes are ordered by
+            file name across all of them.
     -o, --output  <output file>
+        - streams the file to stdout in order, nothing is written to disk.
+            Threads read ahead of the writer within a window of chunks and
+            plain stripes are spliced when stdout is a pipe.
+        Example:
+            -o - | tar -x
 Optional :
     -e, --extension <ext>
         The extension that is searched for.
@@ -119,6 +292,30 @@ Optional :
         Example:
             -n name | "`name`_001.stripe" will match, but
                       "`other_name`_001.stripe" will not.
+    -t, --threads <threads>
+        Stripes copied at once, defaults to the number of input directories
+        Example:
+            -t 4
+    -c, --count <stripes>
+        With --watch and no manifest, the number of stripes in the set.
+            Offsets come from the stripe number and --size, which more than
+            one stripe needs. A stripe closed short of it is waited for.
+        Example:
+            -c 16 -s 64mib
+)" + IO_HELP + R"(    -sh, --shard <k/N>
+        Write only stripes i with i % N == k into a shared output, so N
+            hosts assemble one file together. The output is never truncated
+            and only grown to its full size, 0 also preallocates it. It is
+            complete once all N have finished.
+        Example:
+            -sh 1/4
+    -ss, --set <set id>
+        With headed stripes or bundles, assemble only this set, the 32 hex
+            digit id the errors print. Files of other sets are skipped with
+            a warning. Without it, more than one set in the inputs is an
+            error.
+        Example:
+            -ss 3f0c9a1e5b7d2468ace013579bdf2468
 Flag(s) :
     -q, --quiet <quiet>
         This will silence normal outputs, warnings will still print.
@@ -126,15 +323,128 @@ Flag(s) :
         This will exclusively use files without an extension
     -nn, --no-name <no name>
         This will exclusively use files without a prefix
-Required (2) :
+    -w, --watch <watch>
+        Assemble while stripes arrive. Each one is written at its offset as
+            soon as it is closed or moved into an input directory, files
+            already there are taken as complete. Layout comes from a
+            manifest, a .ready from an --ordered run or --count.
+    -hd, --header <header>
+        Place every file that starts with a stripe header at the offset it
+            gives, whatever it is called. Missing or doubled stripes are an
+            error, stripes of another run one unless --set picks the set,
+            and checksums are verified. Implied for a set without a manifest
+            whose first stripe has a header.
+    -ip, --in-place <in place>
+        Rename the first stripe to the output and append the others to it,
+            in kernel where the filesystem allows. Each stripe is deleted as
+            soon as the output holding it is synced, so only one stripe of
+            extra space is needed. Stripes must be on the output's filesystem
+            and in the input directories, objects of a --store are refused.
+)" + IO_FLAGS_HELP + R"(Required (2) :
 Note: Assembles all files in the order they provided:
     -i, --input <input files>
         Example:
             -i file.txt otherfile.txt ...
     -o, --output <output file>
-Flag(s) :
+        - streams to stdout
+Optional :
+    -t, --threads <threads>
+        Files copied at once
+        Example:
+            -t 4
+)" + IO_HELP + R"(Flag(s) :
     -q, --quiet <quiet>
         This will silence normal outputs, warnings will still print.
+)" + IO_FLAGS_HELP + R"(
+-E, --Extract <Extract>
+    Reads a byte range of the original file straight from its stripes,
+        only the stripes holding it are opened. Works on every kind of set
+        -A assembles.
+Required :
+    -i, --input <input directory> ...
+Optional :
+    -o, --output <output file>
+        Written to stdout when not given
+    -of, --offset <offset>
+        First byte of the range, default 0
+        Example:
+            -of 1.5gib
+    -ln, --length <length>
+        Bytes in the range, default up to the end
+        Example:
+            -ln 10mb
+    -t, --threads <threads>
+        Stripe reads in flight, default 4
+        Example:
+            -t 8
+    -e, --extension <ext>
+    -n, --name  <name suffix>
+    -ss, --set <set id>
+    -sy, --sync <none|end|each|batch>
+    -bs, --buffer-size <buffer size>
+    -mm, --max-memory <max memory>
+Flag(s) :
+    -q, --quiet <quiet>
+    -ne, --no-extension <no extension>
+    -nn, --no-name <no name>
+    -hd, --header <header>
+        Place stripes by their headers as -A --header does
+    -hp, --huge-pages <huge pages>
+
+-R, --Restripe <Restripe>
+    Cuts a stripe set into a new one with another size, count, name or
+        extension. Each new stripe is read straight from the old stripes it
+        overlaps, no assembled file is written. Takes every kind of set -A
+        assembles.
+Required :
+    -i, --input <input directory> ...
+    -o, --output <output directory> ...
+        None of them may hold stripes of the input set.
+    -s, --size <stripe size> | -p, --parts <parts>
+Optional :
+    -on, --out-name <name>
+        Name of the new stripes, default the input name
+    -oe, --out-extension <ext>
+        Extension of the new stripes, default the input extension
+    -t, --threads <threads>
+        Reads in flight, default 4
+    -e, --extension <ext>
+    -n, --name  <name suffix>
+    -ss, --set <set id>
+    -sy, --sync <none|end|each|batch>
+    -bs, --buffer-size <buffer size>
+    -mm, --max-memory <max memory>
+Flag(s) :
+    -q, --quiet <quiet>
+    -ne, --no-extension <no extension>
+    -nn, --no-name <no name>
+    -np, --no-padding <no padding>
+    -m, --manifest <manifest>
+    -hd, --header <header>
+    -hp, --huge-pages <huge pages>
+    -sp, --sparse <sparse>
+
+-M, --Materialize <Materialize>
+    Copies one stripe of an --index-only set straight out of its source.
+        Fails when the source changed since it was indexed.
+Required :
+    -i, --input <index directory>
+    -k, --stripe <stripe number>
+        Example:
+            -k 3
+Optional :
+    -o, --output <output file>
+        Written to stdout when not given
+    -t, --threads <threads>
+        Reads in flight, default 4
+    -n, --name  <name suffix>
+    -sy, --sync <none|end|each|batch>
+    -bs, --buffer-size <buffer size>
+    -mm, --max-memory <max memory>
+Flag(s) :
+    -q, --quiet <quiet>
+    -nn, --no-name <no name>
+    -hp, --huge-pages <huge pages>
 
 Other:
     -h, --help <help>